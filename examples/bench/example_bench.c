@@ -0,0 +1,457 @@
+/*
+
+    -- example_bench.c -- Hardware performance counter benchmark of this library
+
+    -- version 1.0 -- revised 2026-10-18
+
+    -- Changelog --
+
+    - version 1.0 (2026-10-18)
+
+    Encodes and decodes a synthetic corpus of flat, gradient and noisy images
+    and reports cycles, instructions, branch misses and L1 and last level
+    cache misses per pixel for each content class. The counters come from
+    perf_event_open on Linux; anywhere they are unavailable only the wall
+    time is reported and the counters are shown as n/a.
+
+    MIT License
+
+    Copyright (c) 2024-2026 Aftersol
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+
+
+*/
+
+#if defined(__linux__)
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#define SIMPLIFIED_QOI_IMPLEMENTATION
+#include "sQOI.h"
+#include "profile.h"
+
+const char version_number[] = "version 1.0";
+const char revised_date[] = "2026-10-18";
+
+enum bench_counter {COUNTER_CYCLES, COUNTER_INSTRUCTIONS, COUNTER_BRANCH_MISSES, COUNTER_L1D_MISSES, COUNTER_LLC_MISSES, COUNTER_COUNT};
+enum bench_content {CONTENT_FLAT, CONTENT_GRADIENT, CONTENT_NOISY, CONTENT_COUNT};
+
+static const char* counter_names[COUNTER_COUNT] = {"cycles", "instructions", "branch_misses", "l1d_misses", "llc_misses"};
+static const char* content_names[CONTENT_COUNT] = {"flat", "gradient", "noisy"};
+
+/* Counter file descriptors, -1 where a counter is not available */
+typedef struct
+{
+    int fd[COUNTER_COUNT];
+} bench_counters_t;
+
+typedef struct
+{
+    double wall;
+    uint64_t value[COUNTER_COUNT];
+    int available[COUNTER_COUNT];
+} bench_result_t;
+
+void print_version()
+{
+    printf("QOI Benchmark\nversion: %s -- revised %s\n", version_number, revised_date);
+}
+
+void print_help()
+{
+    printf("Example usage: qoi_bench [width] [height] [iterations] [--json]\n");
+    printf("Defaults to a 512x512 corpus encoded and decoded 10 times\n");
+}
+
+#if defined(__linux__)
+static int open_counter(uint32_t type, uint64_t config)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1; /* Works with perf_event_paranoid up to 2 */
+    attr.exclude_hv = 1;
+
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+static void counters_open(bench_counters_t* counters)
+{
+    for (int counter = 0; counter < COUNTER_COUNT; counter++)
+        counters->fd[counter] = -1;
+
+#if defined(__linux__)
+    counters->fd[COUNTER_CYCLES] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    counters->fd[COUNTER_INSTRUCTIONS] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    counters->fd[COUNTER_BRANCH_MISSES] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    counters->fd[COUNTER_L1D_MISSES] = open_counter(
+        PERF_TYPE_HW_CACHE,
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)
+        );
+    counters->fd[COUNTER_LLC_MISSES] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+#endif
+}
+
+static void counters_close(bench_counters_t* counters)
+{
+#if defined(__linux__)
+    for (int counter = 0; counter < COUNTER_COUNT; counter++)
+    {
+        if (counters->fd[counter] >= 0)
+            close(counters->fd[counter]);
+    }
+#else
+    (void)counters;
+#endif
+}
+
+static void counters_start(bench_counters_t* counters)
+{
+#if defined(__linux__)
+    for (int counter = 0; counter < COUNTER_COUNT; counter++)
+    {
+        if (counters->fd[counter] >= 0)
+        {
+            ioctl(counters->fd[counter], PERF_EVENT_IOC_RESET, 0);
+            ioctl(counters->fd[counter], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#else
+    (void)counters;
+#endif
+}
+
+static void counters_stop(bench_counters_t* counters, bench_result_t* result)
+{
+    for (int counter = 0; counter < COUNTER_COUNT; counter++)
+    {
+        result->available[counter] = 0;
+        result->value[counter] = 0;
+
+#if defined(__linux__)
+        if (counters->fd[counter] >= 0)
+        {
+            uint64_t value;
+
+            ioctl(counters->fd[counter], PERF_EVENT_IOC_DISABLE, 0);
+
+            if (read(counters->fd[counter], &value, sizeof(value)) == sizeof(value))
+            {
+                result->value[counter] = value;
+                result->available[counter] = 1;
+            }
+        }
+#endif
+    }
+}
+
+/* Deterministic pseudo random numbers so every run sees the same corpus */
+static uint32_t next_random(uint32_t* state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+/* Fills an image with one content class of the synthetic corpus */
+static void make_content(uint8_t* pixels, uint32_t width, uint32_t height, uint8_t channels, int content)
+{
+    uint32_t state = 0x51D0 + content;
+    size_t seek = 0;
+
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            uint8_t px[4];
+
+            switch (content)
+            {
+                case CONTENT_FLAT:
+                {
+                    /* Large blocks of solid color like user interfaces and pixel art */
+                    uint32_t block = (x / 64) + (y / 48) * 7;
+
+                    px[0] = (uint8_t)(block * 37);
+                    px[1] = (uint8_t)(block * 91);
+                    px[2] = (uint8_t)(block * 13);
+                    px[3] = 255;
+                    break;
+                }
+                case CONTENT_GRADIENT:
+                {
+                    /* Smooth gradients with light noise like photos of skies and renders */
+                    uint32_t noise = next_random(&state) % 3;
+
+                    px[0] = (uint8_t)((x * 255) / (width ? width : 1) + noise);
+                    px[1] = (uint8_t)((y * 255) / (height ? height : 1) + noise);
+                    px[2] = (uint8_t)((x + y) / 4 + noise);
+                    px[3] = (uint8_t)(255 - (y & 7));
+                    break;
+                }
+                default:
+                {
+                    /* Sensor noise that defeats every opcode except QOI_OP_RGB and QOI_OP_RGBA */
+                    uint32_t value = next_random(&state);
+
+                    px[0] = (uint8_t)value;
+                    px[1] = (uint8_t)(value >> 8);
+                    px[2] = (uint8_t)(value >> 16);
+                    px[3] = (uint8_t)(next_random(&state) >> 4);
+                    break;
+                }
+            }
+
+            for (uint8_t channel = 0; channel < channels; channel++)
+                pixels[seek + channel] = px[channel];
+
+            seek += channels;
+        }
+    }
+}
+
+static size_t encode_image(qoi_desc_t* desc, uint8_t* pixels, uint8_t* qoi_file)
+{
+    qoi_enc_t enc;
+    uint8_t* pixel_seek = pixels;
+
+    write_qoi_header(desc, qoi_file);
+
+    if (!qoi_enc_init(desc, &enc, qoi_file))
+        return 0;
+
+    while (!qoi_enc_done(&enc))
+    {
+        qoi_encode_chunk(desc, &enc, pixel_seek);
+        pixel_seek += desc->channels;
+    }
+
+    return (size_t)(enc.offset - enc.data);
+}
+
+static bool decode_image(qoi_desc_t* desc, uint8_t* qoi_file, size_t len, uint8_t* bytes)
+{
+    qoi_dec_t dec;
+    size_t seek = 0;
+
+    if (!qoi_dec_init(desc, &dec, qoi_file, len))
+        return false;
+
+    while (!qoi_dec_done(&dec))
+    {
+        qoi_pixel_t px = qoi_decode_chunk(&dec);
+
+        bytes[seek] = px.red;
+        bytes[seek + 1] = px.green;
+        bytes[seek + 2] = px.blue;
+
+        if (desc->channels > 3) bytes[seek + 3] = px.alpha;
+
+        seek += desc->channels;
+    }
+
+    return true;
+}
+
+static void print_result(const char* operation, const char* content, uint8_t channels, double pixels, size_t qoi_len, size_t raw_len, bench_result_t* result, int json, int* first)
+{
+    if (json)
+    {
+        printf("%s\n    {\"operation\": \"%s\", \"content\": \"%s\", \"channels\": %u, \"ratio\": %.4f, \"ns_per_pixel\": %.4f",
+            *first ? "" : ",", operation, content, channels, (double)raw_len / (double)qoi_len, result->wall * 1e9 / pixels);
+
+        for (int counter = 0; counter < COUNTER_COUNT; counter++)
+        {
+            if (result->available[counter])
+                printf(", \"%s_per_pixel\": %.4f", counter_names[counter], (double)result->value[counter] / pixels);
+            else
+                printf(", \"%s_per_pixel\": null", counter_names[counter]);
+        }
+
+        printf("}");
+        *first = 0;
+    }
+    else
+    {
+        printf("%-7s %-9s %3u %7.3f %9.3f", operation, content, channels, (double)raw_len / (double)qoi_len, result->wall * 1e9 / pixels);
+
+        for (int counter = 0; counter < COUNTER_COUNT; counter++)
+        {
+            if (result->available[counter])
+                printf(" %13.4f", (double)result->value[counter] / pixels);
+            else
+                printf(" %13s", "n/a");
+        }
+
+        printf("\n");
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    bench_counters_t counters;
+    uint32_t width = 512, height = 512, iterations = 10;
+    int json = 0, first = 1, positional = 0, available = 0;
+
+    for (int arg = 1; arg < argc; arg++)
+    {
+        if (strcmp(argv[arg], "--json") == 0)
+        {
+            json = 1;
+        }
+        else if (strcmp(argv[arg], "--help") == 0)
+        {
+            print_version();
+            print_help();
+            return 0;
+        }
+        else
+        {
+            unsigned long value = strtoul(argv[arg], NULL, 0);
+
+            if (value == 0 || value > 65536)
+            {
+                print_version();
+                print_help();
+                return -1;
+            }
+
+            if (positional == 0) width = (uint32_t)value;
+            else if (positional == 1) height = (uint32_t)value;
+            else if (positional == 2) iterations = (uint32_t)value;
+
+            positional++;
+        }
+    }
+
+    if (!json)
+        print_version();
+
+    counters_open(&counters);
+
+    for (int counter = 0; counter < COUNTER_COUNT; counter++)
+        available += (counters.fd[counter] >= 0);
+
+    if (!json)
+    {
+        if (available == 0)
+            printf("Hardware performance counters are not available, reporting wall time only\n");
+
+        printf("%ux%u pixels, %u iterations\n\n", width, height, iterations);
+        printf("%-7s %-9s %3s %7s %9s", "op", "content", "ch", "ratio", "ns/px");
+
+        for (int counter = 0; counter < COUNTER_COUNT; counter++)
+            printf(" %13s", counter_names[counter]);
+
+        printf("\n");
+    }
+    else
+    {
+        printf("{\"width\": %u, \"height\": %u, \"iterations\": %u, \"counters_available\": %s, \"results\": [",
+            width, height, iterations, available ? "true" : "false");
+    }
+
+    for (uint8_t channels = 3; channels <= 4; channels++)
+    {
+        size_t raw_len = (size_t)width * (size_t)height * channels;
+        uint8_t* pixels = (uint8_t*)malloc(raw_len);
+        uint8_t* decoded = (uint8_t*)malloc(raw_len + 4);
+        uint8_t* qoi_file = (uint8_t*)malloc((size_t)width * (size_t)height * (channels + 1) + 14 + 8);
+        double pixel_count = (double)width * (double)height * (double)iterations;
+
+        if (!pixels || !decoded || !qoi_file)
+        {
+            printf("Cannot allocate the benchmark corpus\n");
+            return 1;
+        }
+
+        for (int content = 0; content < CONTENT_COUNT; content++)
+        {
+            bench_result_t result;
+            qoi_desc_t desc;
+            size_t qoi_len = 0;
+            double start;
+
+            qoi_desc_init(&desc);
+            qoi_set_dimensions(&desc, width, height);
+            qoi_set_channels(&desc, channels);
+            qoi_set_colorspace(&desc, QOI_SRGB);
+
+            make_content(pixels, width, height, channels, content);
+
+            /* Warm up caches and page in the buffers before measuring */
+            qoi_len = encode_image(&desc, pixels, qoi_file);
+
+            if (qoi_len == 0 || !decode_image(&desc, qoi_file, qoi_len, decoded))
+            {
+                fprintf(stderr, "Skipping %s content with %u channels: the encoder or decoder failed to initialize\n", content_names[content], channels);
+                continue;
+            }
+
+            start = profile_wall_time();
+            counters_start(&counters);
+
+            for (uint32_t iteration = 0; iteration < iterations; iteration++)
+                qoi_len = encode_image(&desc, pixels, qoi_file);
+
+            counters_stop(&counters, &result);
+            result.wall = profile_wall_time() - start;
+
+            print_result("encode", content_names[content], channels, pixel_count, qoi_len, raw_len, &result, json, &first);
+
+            start = profile_wall_time();
+            counters_start(&counters);
+
+            for (uint32_t iteration = 0; iteration < iterations; iteration++)
+                decode_image(&desc, qoi_file, qoi_len, decoded);
+
+            counters_stop(&counters, &result);
+            result.wall = profile_wall_time() - start;
+
+            print_result("decode", content_names[content], channels, pixel_count, qoi_len, raw_len, &result, json, &first);
+        }
+
+        free(pixels);
+        free(decoded);
+        free(qoi_file);
+    }
+
+    if (json)
+        printf("\n]}\n");
+
+    counters_close(&counters);
+
+    return 0;
+}
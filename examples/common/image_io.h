@@ -0,0 +1,672 @@
+/*
+
+    -- image_io.h -- Streaming PPM, PAM, BMP and TGA readers and writers for the example programs
+
+    -- version 1.0 -- revised 2026-10-18
+
+    -- Changelog --
+
+    - version 1.0 (2026-10-18)
+
+    Readers hand out RGB or RGBA rows from the top of the image down and
+    writers take them in the same order, whatever order the file stores
+    its rows in, so only one row of pixels is ever held in memory.
+
+    Supported files
+        - Binary PPM (P6) with any maximum value up to 65535
+        - PAM (P7) with GRAYSCALE, GRAYSCALE_ALPHA, RGB and RGB_ALPHA tuples
+        - Uncompressed 24 and 32-bit BMP, top-down or bottom-up, including bit fields
+        - Uncompressed 24 and 32-bit true color TGA, top-down or bottom-up
+
+    MIT License
+
+    Copyright (c) 2024-2026 Aftersol
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+
+
+*/
+
+#ifndef QOI_EXAMPLE_IMAGE_IO_H
+#define QOI_EXAMPLE_IMAGE_IO_H
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum image_format {IMAGE_RAW, IMAGE_PPM, IMAGE_PAM, IMAGE_BMP, IMAGE_TGA};
+
+typedef struct
+{
+    FILE* fp;
+    int format;
+
+    uint32_t width, height;
+    uint8_t channels; /* channels of the rows handed out: 3 or 4 */
+
+    uint8_t file_channels; /* samples per pixel stored in the file */
+    uint8_t sample_bytes; /* 1, or 2 for PNM files with a maximum value above 255 */
+    uint32_t max_value;
+
+    int bottom_up; /* last row of the image is stored first */
+    uint8_t positions[4]; /* byte of each channel inside a stored pixel */
+
+    long data_offset;
+    size_t row_stride; /* bytes per stored row including padding */
+    uint32_t row; /* next row handed out */
+
+    uint8_t* file_row;
+} image_reader_t;
+
+typedef struct
+{
+    FILE* fp;
+    int format;
+
+    uint32_t width, height;
+    uint8_t channels; /* channels of the rows given to the writer */
+    uint8_t file_channels;
+
+    int bottom_up;
+
+    long data_offset;
+    size_t row_stride;
+    uint32_t row;
+
+    uint8_t* file_row;
+} image_writer_t;
+
+/* Picks the image format from the extension of a path; anything unknown is raw pixels */
+static inline int image_format_from_path(const char* path)
+{
+    const char* extension = strrchr(path, '.');
+    char lower[8] = {0};
+    size_t length;
+
+    if (!extension) return IMAGE_RAW;
+
+    length = strlen(extension + 1);
+    if (length == 0 || length >= sizeof(lower)) return IMAGE_RAW;
+
+    /* The last byte of lower stays the terminator */
+    for (size_t seek = 0; seek < length && seek < sizeof(lower) - 1; seek++)
+        lower[seek] = (char)tolower((unsigned char)extension[1 + seek]);
+
+    if (strcmp(lower, "ppm") == 0 || strcmp(lower, "pnm") == 0) return IMAGE_PPM;
+    if (strcmp(lower, "pam") == 0) return IMAGE_PAM;
+    if (strcmp(lower, "bmp") == 0 || strcmp(lower, "dib") == 0) return IMAGE_BMP;
+    if (strcmp(lower, "tga") == 0) return IMAGE_TGA;
+
+    return IMAGE_RAW;
+}
+
+static inline uint16_t image_le16(const uint8_t* bytes)
+{
+    return (uint16_t)(bytes[0] | (bytes[1] << 8));
+}
+
+static inline uint32_t image_le32(const uint8_t* bytes)
+{
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+static inline void image_put_le16(uint8_t* bytes, uint16_t value)
+{
+    bytes[0] = (uint8_t)value;
+    bytes[1] = (uint8_t)(value >> 8);
+}
+
+static inline void image_put_le32(uint8_t* bytes, uint32_t value)
+{
+    bytes[0] = (uint8_t)value;
+    bytes[1] = (uint8_t)(value >> 8);
+    bytes[2] = (uint8_t)(value >> 16);
+    bytes[3] = (uint8_t)(value >> 24);
+}
+
+/* Reads the next whitespace separated token of a PNM header, skipping comments */
+static inline int image_pnm_token(FILE* fp, char* token, size_t size)
+{
+    size_t length = 0;
+    int c = fgetc(fp);
+
+    for (;;)
+    {
+        while (c != EOF && isspace(c))
+            c = fgetc(fp);
+
+        if (c != '#') break;
+
+        while (c != EOF && c != '\n')
+            c = fgetc(fp);
+    }
+
+    while (c != EOF && !isspace(c) && length + 1 < size)
+    {
+        token[length++] = (char)c;
+        c = fgetc(fp);
+    }
+
+    token[length] = '\0';
+
+    /* The single whitespace after the last header token is consumed here */
+    return length > 0;
+}
+
+static inline int image_read_ppm_header(image_reader_t* reader)
+{
+    char token[32];
+    unsigned long values[3];
+
+    for (int value = 0; value < 3; value++)
+    {
+        if (!image_pnm_token(reader->fp, token, sizeof(token))) return 0;
+        values[value] = strtoul(token, NULL, 10);
+    }
+
+    reader->width = (uint32_t)values[0];
+    reader->height = (uint32_t)values[1];
+    reader->max_value = (uint32_t)values[2];
+    reader->file_channels = 3;
+    reader->channels = 3;
+
+    return 1;
+}
+
+static inline int image_read_pam_header(image_reader_t* reader)
+{
+    char line[256];
+    unsigned long depth = 0;
+    int has_alpha = -1;
+
+    while (fgets(line, sizeof(line), reader->fp))
+    {
+        char key[32], value[64];
+
+        if (line[0] == '#') continue;
+
+        if (sscanf(line, "%31s %63s", key, value) < 1) continue;
+
+        if (strcmp(key, "ENDHDR") == 0) break;
+        else if (strcmp(key, "WIDTH") == 0) reader->width = (uint32_t)strtoul(value, NULL, 10);
+        else if (strcmp(key, "HEIGHT") == 0) reader->height = (uint32_t)strtoul(value, NULL, 10);
+        else if (strcmp(key, "DEPTH") == 0) depth = strtoul(value, NULL, 10);
+        else if (strcmp(key, "MAXVAL") == 0) reader->max_value = (uint32_t)strtoul(value, NULL, 10);
+        else if (strcmp(key, "TUPLTYPE") == 0) has_alpha = (strstr(value, "_ALPHA") != NULL);
+    }
+
+    if (depth < 1 || depth > 4) return 0;
+
+    /* Without a tuple type an even depth is taken to end with alpha */
+    if (has_alpha < 0) has_alpha = (depth == 2 || depth == 4);
+
+    reader->file_channels = (uint8_t)depth;
+    reader->channels = has_alpha ? 4 : 3;
+
+    return 1;
+}
+
+static inline int image_read_bmp_header(image_reader_t* reader)
+{
+    uint8_t header[14 + 124];
+    uint32_t dib_size, compression, bits;
+    uint32_t masks[4] = {0x00FF0000, 0x0000FF00, 0x000000FF, 0};
+    int32_t height;
+
+    if (fread(header, 1, 14 + 4, reader->fp) != 14 + 4) return 0;
+
+    reader->data_offset = (long)image_le32(header + 10);
+    dib_size = image_le32(header + 14);
+
+    if (dib_size < 40 || dib_size > 124) return 0;
+
+    if (fread(header + 18, 1, dib_size - 4, reader->fp) != dib_size - 4) return 0;
+
+    reader->width = image_le32(header + 18);
+    height = (int32_t)image_le32(header + 22);
+    bits = image_le16(header + 28);
+    compression = image_le32(header + 30);
+
+    /* A negative height means the rows are stored from the top down */
+    reader->bottom_up = (height > 0);
+    reader->height = (height > 0) ? (uint32_t)height : (uint32_t)(-(int64_t)height);
+
+    if (bits != 24 && bits != 32) return 0;
+
+    if (compression == 3 || compression == 6)
+    {
+        /* BI_BITFIELDS and BI_ALPHABITFIELDS: masks follow a 40 byte header or live inside larger ones */
+        uint8_t extra[16];
+        const uint8_t* mask_bytes = header + 14 + 40;
+
+        if (dib_size == 40)
+        {
+            size_t mask_count = (compression == 6) ? 4 : 3;
+
+            if (fread(extra, 4, mask_count, reader->fp) != mask_count) return 0;
+
+            mask_bytes = extra;
+            masks[3] = (compression == 6) ? image_le32(extra + 12) : 0;
+        }
+        else
+        {
+            masks[3] = (dib_size >= 56) ? image_le32(mask_bytes + 12) : 0;
+        }
+
+        masks[0] = image_le32(mask_bytes);
+        masks[1] = image_le32(mask_bytes + 4);
+        masks[2] = image_le32(mask_bytes + 8);
+    }
+    else if (compression == 0)
+    {
+        /* The fourth byte of 32-bit BI_RGB pixels is unused */
+        masks[3] = 0;
+    }
+    else
+    {
+        return 0;
+    }
+
+    /* Only byte aligned 8-bit channel masks are supported */
+    for (int channel = 0; channel < 4; channel++)
+    {
+        int found = 0;
+
+        if (masks[channel] == 0 && channel == 3) break;
+
+        for (int byte = 0; byte < (int)(bits / 8); byte++)
+        {
+            if (masks[channel] == (uint32_t)0xFF << (byte * 8))
+            {
+                reader->positions[channel] = (uint8_t)byte;
+                found = 1;
+            }
+        }
+
+        if (!found) return 0;
+    }
+
+    reader->file_channels = (uint8_t)(bits / 8);
+    reader->channels = masks[3] ? 4 : 3;
+    reader->max_value = 255;
+    reader->row_stride = ((size_t)reader->width * bits + 31) / 32 * 4;
+
+    return 1;
+}
+
+static inline int image_read_tga_header(image_reader_t* reader)
+{
+    uint8_t header[18];
+    uint8_t bits, descriptor;
+
+    if (fread(header, 1, sizeof(header), reader->fp) != sizeof(header)) return 0;
+
+    /* Only uncompressed true color images without a color map */
+    if (header[1] != 0 || header[2] != 2) return 0;
+
+    reader->width = image_le16(header + 12);
+    reader->height = image_le16(header + 14);
+    bits = header[16];
+    descriptor = header[17];
+
+    if (bits != 24 && bits != 32) return 0;
+
+    /* Right to left pixel order is not supported */
+    if (descriptor & 0x10) return 0;
+
+    reader->bottom_up = !(descriptor & 0x20);
+    reader->data_offset = 18 + header[0];
+
+    reader->file_channels = bits / 8;
+    reader->channels = (bits == 32 && (descriptor & 0x0F)) ? 4 : 3;
+    reader->max_value = 255;
+    reader->row_stride = (size_t)reader->width * reader->file_channels;
+
+    reader->positions[0] = 2;
+    reader->positions[1] = 1;
+    reader->positions[2] = 0;
+    reader->positions[3] = 3;
+
+    return 1;
+}
+
+/* Opens an image file and reads its header. Returns 0 if the file cannot be read */
+static inline int image_reader_open(image_reader_t* reader, const char* path)
+{
+    char magic[3] = {0, 0, 0};
+    int ok = 0;
+
+    memset(reader, 0, sizeof(image_reader_t));
+
+    reader->format = image_format_from_path(path);
+    reader->fp = fopen(path, "rb");
+
+    if (!reader->fp) return 0;
+
+    /* The magic bytes decide how a PNM file is read rather than its extension */
+    if (reader->format == IMAGE_PPM || reader->format == IMAGE_PAM)
+    {
+        if (fread(magic, 1, 2, reader->fp) != 2 || magic[0] != 'P') ok = 0;
+        else if (magic[1] == '6') ok = (reader->format = IMAGE_PPM, image_read_ppm_header(reader));
+        else if (magic[1] == '7') ok = (reader->format = IMAGE_PAM, image_read_pam_header(reader));
+
+        if (ok)
+        {
+            reader->data_offset = ftell(reader->fp);
+            reader->sample_bytes = (reader->max_value > 255) ? 2 : 1;
+            reader->row_stride = (size_t)reader->width * reader->file_channels * reader->sample_bytes;
+            ok = (reader->max_value >= 1 && reader->max_value <= 65535);
+        }
+    }
+    else if (reader->format == IMAGE_BMP)
+    {
+        ok = (fread(magic, 1, 2, reader->fp) == 2 && magic[0] == 'B' && magic[1] == 'M');
+
+        if (ok)
+        {
+            fseek(reader->fp, 0, SEEK_SET);
+            ok = image_read_bmp_header(reader);
+        }
+    }
+    else if (reader->format == IMAGE_TGA)
+    {
+        ok = image_read_tga_header(reader);
+    }
+
+    if (ok && (reader->width == 0 || reader->height == 0))
+        ok = 0;
+
+    if (ok)
+    {
+        reader->file_row = (uint8_t*)malloc(reader->row_stride + 4);
+        ok = (reader->file_row != NULL);
+    }
+
+    if (ok && fseek(reader->fp, reader->data_offset, SEEK_SET) != 0)
+        ok = 0;
+
+    if (!ok)
+    {
+        fclose(reader->fp);
+        free(reader->file_row);
+        reader->fp = NULL;
+        reader->file_row = NULL;
+    }
+
+    return ok;
+}
+
+/* Scales a PNM sample to 8 bits */
+static inline uint8_t image_pnm_sample(const image_reader_t* reader, const uint8_t* sample)
+{
+    uint32_t value = (reader->sample_bytes == 2) ? (uint32_t)((sample[0] << 8) | sample[1]) : sample[0];
+
+    if (value > reader->max_value) value = reader->max_value;
+
+    if (reader->max_value == 255) return (uint8_t)value;
+
+    return (uint8_t)((value * 255 + reader->max_value / 2) / reader->max_value);
+}
+
+/* Reads the next row from the top of the image as reader->channels channel pixels */
+static inline int image_reader_read_row(image_reader_t* reader, uint8_t* row)
+{
+    uint8_t* file_row = reader->file_row;
+
+    if (reader->row >= reader->height) return 0;
+
+    /* Bottom-up files are read backwards one row at a time */
+    if (reader->bottom_up)
+    {
+        long offset = reader->data_offset + (long)((size_t)(reader->height - 1 - reader->row) * reader->row_stride);
+
+        if (fseek(reader->fp, offset, SEEK_SET) != 0) return 0;
+    }
+
+    if (fread(file_row, 1, reader->row_stride, reader->fp) != reader->row_stride) return 0;
+
+    reader->row++;
+
+    if (reader->format == IMAGE_PPM || reader->format == IMAGE_PAM)
+    {
+        size_t sample_stride = reader->sample_bytes;
+
+        for (uint32_t x = 0; x < reader->width; x++)
+        {
+            const uint8_t* px = file_row + (size_t)x * reader->file_channels * sample_stride;
+
+            if (reader->file_channels <= 2)
+            {
+                /* Grayscale expands to all three color channels */
+                uint8_t gray = image_pnm_sample(reader, px);
+
+                row[0] = gray;
+                row[1] = gray;
+                row[2] = gray;
+
+                if (reader->channels == 4)
+                    row[3] = (reader->file_channels == 2) ? image_pnm_sample(reader, px + sample_stride) : 255;
+            }
+            else
+            {
+                row[0] = image_pnm_sample(reader, px);
+                row[1] = image_pnm_sample(reader, px + sample_stride);
+                row[2] = image_pnm_sample(reader, px + sample_stride * 2);
+
+                if (reader->channels == 4)
+                    row[3] = (reader->file_channels == 4) ? image_pnm_sample(reader, px + sample_stride * 3) : 255;
+            }
+
+            row += reader->channels;
+        }
+    }
+    else
+    {
+        /* BMP and TGA store blue first; positions undo the swizzle */
+        for (uint32_t x = 0; x < reader->width; x++)
+        {
+            const uint8_t* px = file_row + (size_t)x * reader->file_channels;
+
+            row[0] = px[reader->positions[0]];
+            row[1] = px[reader->positions[1]];
+            row[2] = px[reader->positions[2]];
+
+            if (reader->channels == 4)
+                row[3] = px[reader->positions[3]];
+
+            row += reader->channels;
+        }
+    }
+
+    return 1;
+}
+
+static inline void image_reader_close(image_reader_t* reader)
+{
+    if (reader->fp) fclose(reader->fp);
+    free(reader->file_row);
+
+    reader->fp = NULL;
+    reader->file_row = NULL;
+}
+
+/*
+    Creates an image file and writes its header. Rows are then given from the top down.
+    PPM files have no alpha channel so RGBA images lose their alpha there.
+*/
+static inline int image_writer_open(image_writer_t* writer, const char* path, int format, uint32_t width, uint32_t height, uint8_t channels)
+{
+    memset(writer, 0, sizeof(image_writer_t));
+
+    writer->format = format;
+    writer->width = width;
+    writer->height = height;
+    writer->channels = channels;
+
+    if (format == IMAGE_RAW || width == 0 || height == 0 || channels < 3 || channels > 4) return 0;
+
+    /* BMP and TGA keep 16-bit dimensions or signed 32-bit ones */
+    if (format == IMAGE_TGA && (width > 65535 || height > 65535)) return 0;
+    if (format == IMAGE_BMP && (width > INT32_MAX || height > INT32_MAX)) return 0;
+
+    writer->file_channels = (format == IMAGE_PPM) ? 3 : channels;
+    writer->row_stride = (size_t)width * writer->file_channels;
+
+    if (format == IMAGE_BMP)
+        writer->row_stride = (writer->row_stride + 3) / 4 * 4;
+
+    writer->file_row = (uint8_t*)calloc(writer->row_stride + 4, 1);
+    writer->fp = fopen(path, "wb");
+
+    if (!writer->fp || !writer->file_row)
+    {
+        if (writer->fp) fclose(writer->fp);
+        free(writer->file_row);
+        return 0;
+    }
+
+    switch (format)
+    {
+        case IMAGE_PPM:
+        {
+            fprintf(writer->fp, "P6\n%u %u\n255\n", width, height);
+            break;
+        }
+        case IMAGE_PAM:
+        {
+            fprintf(writer->fp, "P7\nWIDTH %u\nHEIGHT %u\nDEPTH %u\nMAXVAL 255\nTUPLTYPE %s\nENDHDR\n",
+                width, height, channels, (channels == 4) ? "RGB_ALPHA" : "RGB");
+            break;
+        }
+        case IMAGE_BMP:
+        {
+            /* 24-bit BI_RGB for RGB, 32-bit BI_BITFIELDS with a BITMAPV4HEADER for RGBA */
+            uint8_t header[14 + 108];
+            uint32_t dib_size = (channels == 4) ? 108 : 40;
+            uint64_t image_size = (uint64_t)writer->row_stride * height;
+
+            memset(header, 0, sizeof(header));
+
+            header[0] = 'B';
+            header[1] = 'M';
+            image_put_le32(header + 2, (uint32_t)(14 + dib_size + image_size));
+            image_put_le32(header + 10, 14 + dib_size);
+
+            image_put_le32(header + 14, dib_size);
+            image_put_le32(header + 18, width);
+            image_put_le32(header + 22, height); /* positive height: bottom-up, readable everywhere */
+            image_put_le16(header + 26, 1);
+            image_put_le16(header + 28, (uint16_t)(channels * 8));
+            image_put_le32(header + 30, (channels == 4) ? 3 : 0);
+            image_put_le32(header + 34, (uint32_t)image_size);
+            image_put_le32(header + 38, 2835); /* 72 DPI */
+            image_put_le32(header + 42, 2835);
+
+            if (channels == 4)
+            {
+                image_put_le32(header + 54, 0x00FF0000);
+                image_put_le32(header + 58, 0x0000FF00);
+                image_put_le32(header + 62, 0x000000FF);
+                image_put_le32(header + 66, 0xFF000000);
+                image_put_le32(header + 70, 0x73524742); /* LCS_sRGB */
+            }
+
+            fwrite(header, 1, 14 + dib_size, writer->fp);
+
+            writer->bottom_up = 1;
+            break;
+        }
+        case IMAGE_TGA:
+        {
+            uint8_t header[18];
+
+            memset(header, 0, sizeof(header));
+
+            header[2] = 2; /* Uncompressed true color */
+            image_put_le16(header + 12, (uint16_t)width);
+            image_put_le16(header + 14, (uint16_t)height);
+            header[16] = (uint8_t)(channels * 8);
+            header[17] = (uint8_t)(0x20 | ((channels == 4) ? 8 : 0)); /* Top-down with 8 alpha bits for RGBA */
+
+            fwrite(header, 1, sizeof(header), writer->fp);
+            break;
+        }
+    }
+
+    writer->data_offset = ftell(writer->fp);
+
+    return 1;
+}
+
+/* Writes the next row from the top of the image given as writer->channels channel pixels */
+static inline int image_writer_write_row(image_writer_t* writer, const uint8_t* row)
+{
+    uint8_t* file_row = writer->file_row;
+    int bgr = (writer->format == IMAGE_BMP || writer->format == IMAGE_TGA);
+
+    if (writer->row >= writer->height) return 0;
+
+    for (uint32_t x = 0; x < writer->width; x++)
+    {
+        file_row[0] = bgr ? row[2] : row[0];
+        file_row[1] = row[1];
+        file_row[2] = bgr ? row[0] : row[2];
+
+        if (writer->file_channels == 4)
+            file_row[3] = row[3];
+
+        file_row += writer->file_channels;
+        row += writer->channels;
+    }
+
+    /* Bottom-up files get each row written at its place from the end */
+    if (writer->bottom_up)
+    {
+        long offset = writer->data_offset + (long)((size_t)(writer->height - 1 - writer->row) * writer->row_stride);
+
+        if (fseek(writer->fp, offset, SEEK_SET) != 0) return 0;
+    }
+
+    writer->row++;
+
+    return fwrite(writer->file_row, 1, writer->row_stride, writer->fp) == writer->row_stride;
+}
+
+/* Finishes writing an image; returns 0 if anything failed to be written */
+static inline int image_writer_close(image_writer_t* writer)
+{
+    int ok = 1;
+
+    if (writer->fp)
+    {
+        ok = !ferror(writer->fp) && writer->row == writer->height;
+        ok = (fclose(writer->fp) == 0) && ok;
+    }
+
+    free(writer->file_row);
+
+    writer->fp = NULL;
+    writer->file_row = NULL;
+
+    return ok;
+}
+
+#endif /* QOI_EXAMPLE_IMAGE_IO_H */
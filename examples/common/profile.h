@@ -0,0 +1,286 @@
+/*
+
+    -- profile.h -- Phase timing and resource usage reports for the example programs
+
+    -- version 1.0 -- revised 2026-10-18
+
+    -- Changelog --
+
+    - version 1.0 (2026-10-18)
+
+    Pass --profile to print a human readable report or --profile=json
+    for a single line JSON report on stderr once the program is done
+
+    MIT License
+
+    Copyright (c) 2024-2026 Aftersol
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+
+
+*/
+
+#ifndef QOI_EXAMPLE_PROFILE_H
+#define QOI_EXAMPLE_PROFILE_H
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#elif defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#include <sys/time.h>
+#endif
+
+#define PROFILE_MAX_PHASES 8
+
+typedef struct
+{
+    const char* name;
+    double wall, cpu; /* in seconds */
+} profile_phase_t;
+
+typedef struct
+{
+    profile_phase_t phases[PROFILE_MAX_PHASES];
+    int phase_count;
+
+    double wall_start, cpu_start;
+
+    int enabled, json;
+} profile_t;
+
+/* Resource usage of the process so far */
+typedef struct
+{
+    double peak_rss_mib;
+    long minor_faults, major_faults;
+} profile_usage_t;
+
+static inline double profile_wall_time()
+{
+#if defined(_WIN32)
+    LARGE_INTEGER counter, frequency;
+
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#else
+    return (double)time(NULL);
+#endif
+}
+
+static inline double profile_cpu_time()
+{
+#if defined(_WIN32)
+    FILETIME creation, exit, kernel, user;
+    ULARGE_INTEGER kernel_time, user_time;
+
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+        return 0.0;
+
+    kernel_time.LowPart = kernel.dwLowDateTime;
+    kernel_time.HighPart = kernel.dwHighDateTime;
+    user_time.LowPart = user.dwLowDateTime;
+    user_time.HighPart = user.dwHighDateTime;
+
+    /* FILETIME counts in 100 nanosecond intervals */
+    return (double)(kernel_time.QuadPart + user_time.QuadPart) * 1e-7;
+#elif defined(__unix__) || defined(__APPLE__)
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+
+    return (double)usage.ru_utime.tv_sec + (double)usage.ru_utime.tv_usec * 1e-6 +
+        (double)usage.ru_stime.tv_sec + (double)usage.ru_stime.tv_usec * 1e-6;
+#else
+    return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+static inline profile_usage_t profile_get_usage()
+{
+    profile_usage_t result = {0.0, 0, 0};
+
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        result.peak_rss_mib = (double)counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+        result.minor_faults = (long)counters.PageFaultCount; /* Windows does not tell soft and hard faults apart */
+    }
+#elif defined(__unix__) || defined(__APPLE__)
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+
+#if defined(__APPLE__)
+    result.peak_rss_mib = (double)usage.ru_maxrss / (1024.0 * 1024.0); /* bytes on macOS */
+#else
+    result.peak_rss_mib = (double)usage.ru_maxrss / 1024.0; /* KiB on Linux and the BSDs */
+#endif
+
+    result.minor_faults = usage.ru_minflt;
+    result.major_faults = usage.ru_majflt;
+#endif
+
+    return result;
+}
+
+/* Looks for --profile or --profile=json and removes it from the arguments */
+static inline void profile_parse_args(profile_t* profile, int* argc, char* argv[])
+{
+    int arg = 1;
+
+    memset(profile, 0, sizeof(profile_t));
+
+    while (arg < *argc)
+    {
+        if (strcmp(argv[arg], "--profile") == 0 || strcmp(argv[arg], "--profile=json") == 0)
+        {
+            profile->enabled = 1;
+            profile->json = (strcmp(argv[arg], "--profile=json") == 0);
+
+            for (int next = arg; next + 1 < *argc; next++)
+                argv[next] = argv[next + 1];
+
+            (*argc)--;
+            argv[*argc] = NULL;
+        }
+        else
+        {
+            arg++;
+        }
+    }
+}
+
+/* Starts timing a phase such as reading the file or running the codec */
+static inline void profile_begin(profile_t* profile, const char* name)
+{
+    if (!profile->enabled || profile->phase_count >= PROFILE_MAX_PHASES) return;
+
+    profile->phases[profile->phase_count].name = name;
+    profile->wall_start = profile_wall_time();
+    profile->cpu_start = profile_cpu_time();
+}
+
+/* Stops timing the phase started last */
+static inline void profile_end(profile_t* profile)
+{
+    profile_phase_t* phase;
+
+    if (!profile->enabled || profile->phase_count >= PROFILE_MAX_PHASES) return;
+
+    phase = &profile->phases[profile->phase_count++];
+    phase->wall = profile_wall_time() - profile->wall_start;
+    phase->cpu = profile_cpu_time() - profile->cpu_start;
+}
+
+/*
+    Prints every phase followed by throughput and resource usage.
+    codec_phase names the phase that ran the encoder or decoder loop.
+*/
+static inline void profile_report(profile_t* profile, const char* tool, const char* codec_phase, size_t pixels, size_t raw_bytes, size_t qoi_bytes)
+{
+    profile_usage_t usage;
+    double total_wall = 0.0, total_cpu = 0.0, codec_wall = 0.0;
+    double megapixels_per_second = 0.0, mebibytes_per_second = 0.0, ratio = 0.0;
+
+    if (!profile->enabled) return;
+
+    usage = profile_get_usage();
+
+    for (int phase = 0; phase < profile->phase_count; phase++)
+    {
+        total_wall += profile->phases[phase].wall;
+        total_cpu += profile->phases[phase].cpu;
+
+        if (strcmp(profile->phases[phase].name, codec_phase) == 0)
+            codec_wall = profile->phases[phase].wall;
+    }
+
+    /* Throughput is measured on raw pixel bytes over the codec loop only */
+    if (codec_wall > 0.0)
+    {
+        megapixels_per_second = (double)pixels / codec_wall / 1e6;
+        mebibytes_per_second = (double)raw_bytes / codec_wall / (1024.0 * 1024.0);
+    }
+
+    if (qoi_bytes > 0)
+        ratio = (double)raw_bytes / (double)qoi_bytes;
+
+    /* The JSON report goes to stderr on its own so the progress text on stdout never mixes with it */
+    if (profile->json)
+    {
+        fprintf(stderr, "{\"tool\": \"%s\", \"phases\": [", tool);
+
+        for (int phase = 0; phase < profile->phase_count; phase++)
+        {
+            fprintf(stderr, "%s{\"name\": \"%s\", \"wall_ms\": %.3f, \"cpu_ms\": %.3f}",
+                phase ? ", " : "",
+                profile->phases[phase].name,
+                profile->phases[phase].wall * 1e3,
+                profile->phases[phase].cpu * 1e3
+                );
+        }
+
+        fprintf(stderr, "], \"total_wall_ms\": %.3f, \"total_cpu_ms\": %.3f, ", total_wall * 1e3, total_cpu * 1e3);
+        fprintf(stderr, "\"pixels\": %zu, \"raw_bytes\": %zu, \"qoi_bytes\": %zu, ", pixels, raw_bytes, qoi_bytes);
+        fprintf(stderr, "\"megapixels_per_second\": %.3f, \"mib_per_second\": %.3f, \"compression_ratio\": %.4f, ",
+            megapixels_per_second, mebibytes_per_second, ratio);
+        fprintf(stderr, "\"peak_rss_mib\": %.2f, \"minor_page_faults\": %ld, \"major_page_faults\": %ld}\n",
+            usage.peak_rss_mib, usage.minor_faults, usage.major_faults);
+    }
+    else
+    {
+        printf("\nProfile (%s)\n", tool);
+        printf("%-10s %12s %12s\n", "Phase", "Wall (ms)", "CPU (ms)");
+
+        for (int phase = 0; phase < profile->phase_count; phase++)
+        {
+            printf("%-10s %12.3f %12.3f\n",
+                profile->phases[phase].name,
+                profile->phases[phase].wall * 1e3,
+                profile->phases[phase].cpu * 1e3
+                );
+        }
+
+        printf("%-10s %12.3f %12.3f\n", "total", total_wall * 1e3, total_cpu * 1e3);
+
+        printf("Throughput: %.3f MP/s, %.3f MiB/s\n", megapixels_per_second, mebibytes_per_second);
+        printf("Compression ratio: %.4f (%zu raw bytes, %zu QOI bytes)\n", ratio, raw_bytes, qoi_bytes);
+        printf("Peak RSS: %.2f MiB\n", usage.peak_rss_mib);
+        printf("Page faults: %ld minor, %ld major\n", usage.minor_faults, usage.major_faults);
+    }
+}
+
+#endif /* QOI_EXAMPLE_PROFILE_H */
@@ -0,0 +1,124 @@
+/*
+
+    -- example_cpp.cpp -- Reference usage of the C++17 interface of this library
+
+    -- version 1.0 -- revised 2026-10-18
+
+    -- Changelog --
+
+    - version 1.0 (2026-10-18)
+
+    Converts a QOI file to 3 (RGB) or 4 (RGBA) channels using sqoi.hpp
+
+    MIT License
+
+    Copyright (c) 2024-2026 Aftersol
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+
+
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#define SIMPLIFIED_QOI_IMPLEMENTATION
+
+#include "sqoi.hpp"
+
+const char version_number[] = "version 1.0";
+const char revised_date[] = "2026-10-18";
+
+void print_version()
+{
+    std::printf("QOI Channel Converter (C++)\nversion: %s -- revised %s\n", version_number, revised_date);
+}
+
+void print_help()
+{
+    std::printf("Example usage: qoi_cpp <qoi file> <output qoi file> <channels>\n");
+    std::printf("Channels:\n3: No transparency\n4: Transparency\n");
+}
+
+/* Decode with the requested channel count and encode it again */
+template <unsigned Channels>
+sqoi::buffer convert(const std::vector<uint8_t>& qoi_file)
+{
+    sqoi::desc info;
+    sqoi::buffer pixels = sqoi::decoder<Channels>::decode(qoi_file, &info);
+
+    if (!pixels)
+        return sqoi::buffer();
+
+    return sqoi::encoder<Channels>::encode(pixels, info.width, info.height, info.colorspace);
+}
+
+int main(int argc, char* argv[])
+{
+    print_version();
+
+    if (argc < 4)
+    {
+        print_help();
+        return -1;
+    }
+
+    unsigned long channels = std::strtoul(argv[3], nullptr, 0);
+
+    if (channels < 3 || channels > 4)
+    {
+        std::printf("Channels entered must be 3 (RGB) or 4 (RGBA)\n");
+        print_help();
+        return -1;
+    }
+
+    std::ifstream input(argv[1], std::ios::binary);
+
+    if (!input)
+    {
+        std::printf("Cannot open %s\n", argv[1]);
+        print_help();
+        return -1;
+    }
+
+    std::vector<uint8_t> qoi_file((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+    sqoi::buffer converted = (channels == 3) ? convert<3>(qoi_file) : convert<4>(qoi_file);
+
+    if (!converted)
+    {
+        std::printf("The file you opened is not a valid QOIF file or ends before its last pixel\n");
+        print_help();
+        return 1;
+    }
+
+    std::ofstream output(argv[2], std::ios::binary);
+
+    if (!output)
+        return 4;
+
+    output.write(reinterpret_cast<const char*>(converted.data()), static_cast<std::streamsize>(converted.size()));
+
+    std::printf("Wrote %zu bytes to %s\n", converted.size(), argv[2]);
+
+    return 0;
+}
@@ -2,9 +2,18 @@
 
     -- example_dec.c -- Reference QOI decoding usage of this library
 
-    -- version 1.1.1 -- revised 2026-04-26
+    -- version 1.3 -- revised 2026-10-18
 
     -- Changelog --
+    - version 1.3 (2026-10-18)
+        - Added direct writing of PPM, PAM, BMP and TGA files chosen by
+        the extension of the output file which receive decoded pixels
+        a row at a time
+
+    - version 1.2 (2026-10-18)
+        - Added --profile and --profile=json to report phase timings,
+        throughput, compression ratio, peak memory and page faults
+
     - version 1.1.1 (2026-04-26)
         - Fixed misspelling for decoder's name
         
@@ -49,9 +58,11 @@
 
 #define SIMPLIFIED_QOI_IMPLEMENTATION
 #include "sQOI.h"
+#include "profile.h"
+#include "image_io.h"
 
-const char version_number[] = "version 1.1.2";
-const char revised_date[] = "2026-04-26";
+const char version_number[] = "version 1.3";
+const char revised_date[] = "2026-10-18";
 
 void print_version()
 {
@@ -60,7 +71,90 @@ void print_version()
 
 void print_help()
 {
-    printf("Example usage: qoi_dec <qoi file> <raw output file>\n");
+    printf("Example usage: qoi_dec <qoi file> <raw output file> [--profile[=json]]\n");
+    printf("Output files ending in .ppm, .pam, .bmp or .tga are written as images; PPM drops alpha\n");
+}
+
+/* Decodes straight into a PPM, PAM, BMP or TGA file one row at a time */
+int decode_image_file(qoi_desc_t* desc, qoi_dec_t* dec, const char* input, const char* output, int format, size_t qoi_length, profile_t* profile)
+{
+    image_writer_t writer;
+    qoi_pixel_t px;
+    uint8_t* row;
+    int ok = 1;
+
+    row = (uint8_t*)malloc((size_t)desc->width * desc->channels + 4);
+
+    if (!row)
+        return 3;
+
+    if (!image_writer_open(&writer, output, format, desc->width, desc->height, desc->channels))
+    {
+        printf("Cannot create %s\n", output);
+
+        free(row);
+        return 4;
+    }
+
+    printf("Decoding %s into %s. Please wait . . .\n", input, output);
+
+    profile_begin(profile, "decode");
+
+    for (uint32_t y = 0; y < desc->height && ok; y++)
+    {
+        uint8_t* seek = row;
+
+        for (uint32_t x = 0; x < desc->width; x++)
+        {
+            /* Never read past the end of a truncated file */
+            if (qoi_dec_done(dec))
+                break;
+
+            px = qoi_decode_chunk(dec);
+
+            seek[0] = px.red;
+            seek[1] = px.green;
+            seek[2] = px.blue;
+
+            if (desc->channels > 3) seek[3] = px.alpha;
+
+            seek += desc->channels;
+        }
+
+        if (dec->pixel_seek < (size_t)(y + 1) * desc->width)
+            break;
+
+        ok = image_writer_write_row(&writer, row);
+    }
+
+    ok = image_writer_close(&writer) && ok;
+
+    profile_end(profile);
+
+    free(row);
+
+    if (dec->pixel_seek < dec->img_area)
+    {
+        printf("%s is truncated: only %zu of %zu pixels were decoded\n", input, dec->pixel_seek, dec->img_area);
+        return 1;
+    }
+
+    if (!ok)
+    {
+        printf("An error has occur while writing %s\n", output);
+        return 4;
+    }
+
+    profile_report(
+        profile,
+        "qoi_dec",
+        "decode",
+        (size_t)desc->width * (size_t)desc->height,
+        (size_t)desc->width * (size_t)desc->height * (size_t)desc->channels,
+        qoi_length
+        );
+
+    return 0;
 }
 
 int main(int argc, char* argv[])
@@ -74,9 +168,12 @@ int main(int argc, char* argv[])
     size_t raw_image_length, seek, buffer_size;
 
     FILE* fp;
+    profile_t profile;
 
     print_version();
 
+    profile_parse_args(&profile, &argc, argv);
+
     if (argc < 3)
     {
         print_help();
@@ -93,6 +190,8 @@ int main(int argc, char* argv[])
 
     printf("Opening %s\n", argv[1]);
 
+    profile_begin(&profile, "read");
+
     fp = fopen(argv[1], "rb");
     if (!fp)
     {
@@ -132,6 +231,10 @@ int main(int argc, char* argv[])
 
     fclose(fp);
 
+    profile_end(&profile);
+
+    profile_begin(&profile, "header");
+
     /* Set up QOI decoding process */
     qoi_desc_init(&desc);
 
@@ -140,7 +243,6 @@ int main(int argc, char* argv[])
         printf("The file you opened is not a QOIF file\n");
         print_help();
 
-        fclose(fp);
         free(qoi_bytes);
 
         return 1;
@@ -155,7 +257,6 @@ int main(int argc, char* argv[])
         printf("Color channels retrived from %s is not vaild\n", argv[1]);
         print_help();
 
-        fclose(fp);
         free(qoi_bytes);
 
         return 1;
@@ -165,7 +266,6 @@ int main(int argc, char* argv[])
         printf("Colorspace read from %s is not vaild\n", argv[1]);
         print_help();
 
-        fclose(fp);
         free(qoi_bytes);
 
         return 1;
@@ -176,12 +276,24 @@ int main(int argc, char* argv[])
 
     if (raw_image_length == 0)
     {
-        fclose(fp);
+        free(qoi_bytes);
         return 2;
     }
     
     qoi_dec_init(&desc, &dec, qoi_bytes, buffer_size);
 
+    profile_end(&profile);
+
+    /* Image files are written while decoding so the whole image is never held */
+    if (image_format_from_path(argv[2]) != IMAGE_RAW)
+    {
+        int result = decode_image_file(&desc, &dec, argv[1], argv[2], image_format_from_path(argv[2]), buffer_size, &profile);
+
+        free(qoi_bytes);
+
+        return result;
+    }
+
     /* Creates a blank image for the decoder to work on */
     bytes = (unsigned char*)malloc(raw_image_length * sizeof(unsigned char) + 4);
     if (!bytes)
@@ -191,6 +303,8 @@ int main(int argc, char* argv[])
 
     printf("Decoding %s into %s. Please wait . . .\n", argv[1], argv[2]);
 
+    profile_begin(&profile, "decode");
+
     /*  Keep decoding the pixels until
         all pixels are done decompressing */
     while (!qoi_dec_done(&dec))
@@ -211,6 +325,10 @@ int main(int argc, char* argv[])
 
     free(qoi_bytes);
 
+    profile_end(&profile);
+
+    profile_begin(&profile, "write");
+
     fp = fopen(argv[2], "wb");
 
     if (!fp)
@@ -223,6 +341,17 @@ int main(int argc, char* argv[])
 
     fclose(fp);
 
+    profile_end(&profile);
+
+    profile_report(
+        &profile,
+        "qoi_dec",
+        "decode",
+        (size_t)desc.width * (size_t)desc.height,
+        raw_image_length,
+        buffer_size
+        );
+
     free(bytes);
 
     return 0;
@@ -2,10 +2,21 @@
 
     -- example_enc.c -- Reference QOI encoding usage of this library
 
-    -- version 1.1.2 -- revised 2026-04-16
+    -- version 1.3 -- revised 2026-10-18
 
     -- Changelog --
     
+    - version 1.3 (2026-10-18)
+        - Raw input is encoded into a buffer of the exact QOI file
+        size instead of the worst case size
+        - Added direct reading of PPM, PAM, BMP and TGA files which are
+        streamed into the encoder a row at a time with their dimensions
+        taken from the file header
+
+    - version 1.2 (2026-10-18)
+        - Added --profile and --profile=json to report phase timings,
+        throughput, compression ratio, peak memory and page faults
+
     - version 1.1.2 (2026-04-16)
         - Fixed underflow if thesize of the raw image is smaller
         than requested image size and number of image channels
@@ -55,9 +66,11 @@
 #define QOI_ENC_BUFFER_SIZE 131072 /* Buffer size set to 128 KiB */
 
 #include "sQOI.h"
+#include "profile.h"
+#include "image_io.h"
 
-const char version_number[] = "version 1.1.2";
-const char revised_date[] = "2026-04-16";
+const char version_number[] = "version 1.3";
+const char revised_date[] = "2026-10-18";
 
 void print_version()
 {
@@ -66,26 +79,190 @@ void print_version()
 
 void print_help()
 {
-    printf("Example usage: qoi_enc <filename> <width> <height> <channels> <colorspace> <output>\n");
+    printf("Example usage: qoi_enc <filename> <width> <height> <channels> <colorspace> <output> [--profile[=json]]\n");
+    printf("Image files: qoi_enc <image.ppm|.pam|.bmp|.tga> <output> [colorspace] [--profile[=json]]\n");
     printf("Channels:\n3: No transparency\n4: Transparency\n\n");
     printf("Colorspace:\n0: sRGB with linear alpha\n1: Linear RGB\n");
 }
 
 uint8_t qoi_enc_buffer[QOI_ENC_BUFFER_SIZE];
 
-int main(int argc, char* argv[])
+static void* stdlib_malloc(size_t size, void* user)
+{
+    (void)user;
+    return malloc(size);
+}
+
+static void* stdlib_realloc(void* ptr, size_t size, void* user)
+{
+    (void)user;
+    return realloc(ptr, size);
+}
+
+static void stdlib_free(void* ptr, void* user)
 {
+    (void)user;
+    free(ptr);
+}
+
+const qoi_allocator_t stdlib_allocator = {stdlib_malloc, stdlib_realloc, stdlib_free, NULL};
 
+/* Encodes a PPM, PAM, BMP or TGA file while reading it one row at a time */
+int encode_image_file(const char* input, const char* output, uint8_t colorspace, profile_t* profile)
+{
     qoi_desc_t desc;
     qoi_enc_t enc;
-    uint8_t* qoi_file, *pixel_seek, *file_buffer;
+    image_reader_t reader;
+    uint8_t* qoi_file, *row;
+    FILE* fp;
+
+    printf("Opening %s\n", input);
+
+    profile_begin(profile, "header");
+
+    if (!image_reader_open(&reader, input))
+    {
+        printf("%s is not a supported PPM, PAM, BMP or TGA file\n", input);
+        print_help();
+        return -1;
+    }
+
+    printf("Image dimensions %ux%u\n", reader.width, reader.height);
+    printf("Number of channels: %u\n", reader.channels);
+
+    qoi_desc_init(&desc);
+
+    qoi_set_dimensions(&desc, reader.width, reader.height);
+    qoi_set_channels(&desc, reader.channels);
+    qoi_set_colorspace(&desc, colorspace);
+
+    /* The dimensions come from the file so make sure the worst case QOI file size fits in size_t */
+    if (desc.width == 0 || desc.height == 0)
+    {
+        printf("%s has no pixels to encode\n", input);
+        image_reader_close(&reader);
+        return 1;
+    }
+
+    if (desc.width > ((size_t)-1 - 14 - 8 - sizeof(size_t)) / desc.height / ((size_t)desc.channels + 1))
+    {
+        printf("%s is too large to encode\n", input);
+        image_reader_close(&reader);
+        return 1;
+    }
+
+    qoi_file = (uint8_t*)malloc(((size_t)desc.width * (size_t)desc.height * ((size_t)desc.channels + 1)) + 14 + 8 + sizeof(size_t));
+
+    /* The encoder loads four bytes for every pixel so the row gets slack at its end */
+    row = (uint8_t*)malloc((size_t)desc.width * desc.channels + 4);
+
+    if (!qoi_file || !row)
+    {
+        image_reader_close(&reader);
+        free(qoi_file);
+        free(row);
+        return 1;
+    }
+
+    printf("Encoding %s to %s. Please wait . . .\n", input, output);
+
+    write_qoi_header(&desc, qoi_file);
+
+    profile_end(profile);
+
+    profile_begin(profile, "encode");
+
+    if (!qoi_enc_init(&desc, &enc, qoi_file))
+    {
+        image_reader_close(&reader);
+        free(qoi_file);
+        free(row);
+        return 1;
+    }
+
+    for (uint32_t y = 0; y < desc.height; y++)
+    {
+        uint8_t* pixel_seek = row;
+
+        if (!image_reader_read_row(&reader, row))
+        {
+            printf("An error has occur while reading %s\n", input);
+
+            image_reader_close(&reader);
+            free(qoi_file);
+            free(row);
+
+            return 1;
+        }
+
+        for (uint32_t x = 0; x < desc.width; x++)
+        {
+            qoi_encode_chunk(&desc, &enc, pixel_seek);
+            pixel_seek += desc.channels;
+        }
+    }
+
+    image_reader_close(&reader);
+    free(row);
+
+    profile_end(profile);
+
+    profile_begin(profile, "write");
+
+    fp = fopen(output, "wb");
+
+    if (fp)
+    {
+        fwrite(qoi_file, 1, enc.offset - enc.data, fp);
+        fclose(fp);
+    }
+
+    profile_end(profile);
+
+    profile_report(
+        profile,
+        "qoi_enc",
+        "encode",
+        (size_t)desc.width * (size_t)desc.height,
+        (size_t)desc.width * (size_t)desc.height * (size_t)desc.channels,
+        (size_t)(enc.offset - enc.data)
+        );
+
+    free(qoi_file);
+
+    return fp ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+
+    qoi_desc_t desc;
+    uint8_t* qoi_file, *file_buffer;
     FILE* fp;
     uint32_t width, height;
     uint8_t channels, colorspace;
-    size_t file_size;
+    size_t file_size, qoi_len;
+    profile_t profile;
     
     print_version();
 
+    profile_parse_args(&profile, &argc, argv);
+
+    /* Image files carry their own dimensions and channels */
+    if (argc >= 3 && image_format_from_path(argv[1]) != IMAGE_RAW)
+    {
+        colorspace = (argc >= 4) ? (uint8_t)strtoul(argv[3], NULL, 0) : 0;
+
+        if (colorspace > 1)
+        {
+            printf("Colorspace entered must be 0 (sRGB with linear alpha) or 1 (linear RGB)\n");
+            print_help();
+            return -1;
+        }
+
+        return encode_image_file(argv[1], argv[2], colorspace, &profile);
+    }
+
     if (argc < 6)
     {
         print_help();
@@ -137,6 +314,8 @@ int main(int argc, char* argv[])
 
     printf("Opening %s\n",argv[1]);
 
+    profile_begin(&profile, "read");
+
     fp = fopen(argv[1], "rb");
 
     if (!fp)
@@ -197,42 +376,51 @@ int main(int argc, char* argv[])
 
     fclose(fp);
 
+    profile_end(&profile);
+
     qoi_desc_init(&desc);
     
     qoi_set_dimensions(&desc, width, height);
     qoi_set_channels(&desc, channels);
     qoi_set_colorspace(&desc, colorspace);
-    
-    qoi_file = (uint8_t*)malloc(((size_t)desc.width * (size_t)desc.height * ((size_t)desc.channels + 1)) + 14 + 8 + sizeof(size_t));
-    
-    if (!qoi_file)
-    {
-        return 1;
-    }
 
     printf("Encoding %s to %s. Please wait . . .\n", argv[1], argv[6]);
 
-    write_qoi_header(&desc, qoi_file);
+    /* Counts the exact QOI file size first so the output is never over-allocated */
+    profile_begin(&profile, "encode");
 
-    pixel_seek = file_buffer;
+    qoi_file = (uint8_t*)qoi_encode_image(&desc, file_buffer, &qoi_len, &stdlib_allocator);
 
-    qoi_enc_init(&desc, &enc, qoi_file);
+    profile_end(&profile);
 
-    while(!qoi_enc_done(&enc))
-    {
-        qoi_encode_chunk(&desc, &enc, pixel_seek);
+    free(file_buffer);
 
-        pixel_seek += desc.channels;
+    if (!qoi_file)
+    {
+        return 1;
     }
 
+    profile_begin(&profile, "write");
+
     fp = fopen(argv[6], "wb");
     
     if (fp)
     {
-        fwrite(qoi_file, 1, enc.offset - enc.data, fp);
+        fwrite(qoi_file, 1, qoi_len, fp);
         fclose(fp);
     } 
 
+    profile_end(&profile);
+
+    profile_report(
+        &profile,
+        "qoi_enc",
+        "encode",
+        (size_t)desc.width * (size_t)desc.height,
+        (size_t)desc.width * (size_t)desc.height * (size_t)desc.channels,
+        qoi_len
+        );
+
     free(qoi_file);
 
     return 0;
@@ -0,0 +1,740 @@
+/*
+
+    -- example_pack.c -- QOI archive tool using this library
+
+    -- version 1.1 -- revised 2026-10-18
+
+    -- Changelog --
+
+    - version 1.1 (2026-10-18)
+
+    Splits a QOI file into a tiled container encoded in parallel and
+    decodes any region of one from only the tiles it touches
+
+    - version 1.0 (2026-10-18)
+
+    Packs many QOI files into one indexed archive that can be memory mapped
+    and looked up by name without copying, then lists, extracts or decodes
+    every entry of an archive in parallel to check it
+
+    MIT License
+
+    Copyright (c) 2024-2026 Aftersol
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define QOI_PACK_POSIX
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define SIMPLIFIED_QOI_IMPLEMENTATION
+#include "sQOI.h"
+
+#define QOI_PACK_THREADS 8
+
+const char version_number[] = "version 1.1";
+const char revised_date[] = "2026-10-18";
+
+void print_version()
+{
+    printf("QOI Archive Tool\nversion: %s -- revised %s\n", version_number, revised_date);
+}
+
+void print_help()
+{
+    printf("Example usage:\n");
+    printf("qoi_pack create <archive> <qoi files...>\n");
+    printf("qoi_pack list <archive>\n");
+    printf("qoi_pack extract <archive> <entry name> <output qoi file>\n");
+    printf("qoi_pack verify <archive>\n");
+    printf("qoi_pack tile <qoi file> <tiled output> [tile size]\n");
+    printf("qoi_pack region <tiled file> <x> <y> <width> <height> <output qoi file>\n");
+}
+
+/* A file to be packed */
+typedef struct
+{
+    qoi_archive_entry_t entry;
+    uint8_t* bytes;
+    uint64_t hash;
+} pack_input_t;
+
+/* A whole archive in memory, mapped when possible */
+typedef struct
+{
+    uint8_t* data;
+    size_t len;
+    int mapped;
+} mapped_file_t;
+
+static size_t align_up(size_t value)
+{
+    return (value + QOI_ARCHIVE_ALIGN - 1) / QOI_ARCHIVE_ALIGN * QOI_ARCHIVE_ALIGN;
+}
+
+static uint8_t* read_file(const char* path, size_t* len)
+{
+    FILE* fp = fopen(path, "rb");
+    uint8_t* bytes;
+    long size;
+
+    if (!fp) return NULL;
+
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    if (size < 0)
+    {
+        fclose(fp);
+        return NULL;
+    }
+
+    bytes = (uint8_t*)malloc((size_t)size + 1);
+
+    if (bytes && fread(bytes, 1, (size_t)size, fp) < (size_t)size)
+    {
+        free(bytes);
+        bytes = NULL;
+    }
+
+    fclose(fp);
+
+    *len = (size_t)size;
+
+    return bytes;
+}
+
+static int map_file(const char* path, mapped_file_t* file)
+{
+    file->mapped = 0;
+
+#if defined(QOI_PACK_POSIX)
+    {
+        struct stat info;
+        int fd = open(path, O_RDONLY);
+
+        if (fd >= 0 && fstat(fd, &info) == 0 && info.st_size > 0)
+        {
+            void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            close(fd);
+
+            if (data != MAP_FAILED)
+            {
+                file->data = (uint8_t*)data;
+                file->len = (size_t)info.st_size;
+                file->mapped = 1;
+
+                return 1;
+            }
+        }
+        else if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+#endif
+
+    /* Read the whole file where memory mapping is unavailable */
+    file->data = read_file(path, &file->len);
+
+    return file->data != NULL;
+}
+
+static void unmap_file(mapped_file_t* file)
+{
+#if defined(QOI_PACK_POSIX)
+    if (file->mapped)
+    {
+        munmap(file->data, file->len);
+        return;
+    }
+#endif
+
+    free(file->data);
+}
+
+/* Sorts inputs the same way as the archive index: by name hash, then by name */
+static int compare_inputs(const void* a, const void* b)
+{
+    const pack_input_t* left = (const pack_input_t*)a;
+    const pack_input_t* right = (const pack_input_t*)b;
+    size_t shortest = (left->entry.name_len < right->entry.name_len) ? left->entry.name_len : right->entry.name_len;
+    int order;
+
+    if (left->hash != right->hash)
+        return (left->hash < right->hash) ? -1 : 1;
+
+    order = memcmp(left->entry.name, right->entry.name, shortest);
+
+    if (order != 0)
+        return order;
+
+    return (left->entry.name_len > right->entry.name_len) - (left->entry.name_len < right->entry.name_len);
+}
+
+static int create_archive(const char* path, int count, char* files[])
+{
+    pack_input_t* inputs = (pack_input_t*)calloc((size_t)count, sizeof(pack_input_t));
+    size_t names_len = 0, data_offset, names_offset, index_offset = QOI_ARCHIVE_HEADER_SIZE;
+    uint8_t* table;
+    uint32_t name_offset = 0;
+    FILE* fp;
+    int result = 1;
+
+    if (!inputs) return 3;
+
+    for (int file = 0; file < count; file++)
+    {
+        pack_input_t* input = &inputs[file];
+
+        input->bytes = read_file(files[file], &input->entry.len);
+        input->entry.name = files[file];
+        input->entry.name_len = strlen(files[file]);
+
+        qoi_desc_init(&input->entry.desc);
+
+        if (!input->bytes || input->entry.len < 14 + 8 || !read_qoi_header(&input->entry.desc, input->bytes))
+        {
+            printf("%s is not a QOIF file\n", files[file]);
+            goto cleanup;
+        }
+
+        if (input->entry.name_len > 65535)
+        {
+            printf("%s has a name longer than 65535 bytes\n", files[file]);
+            goto cleanup;
+        }
+
+        input->entry.data = input->bytes;
+        input->hash = qoi_archive_hash(input->entry.name, input->entry.name_len);
+
+        names_len += input->entry.name_len;
+    }
+
+    qsort(inputs, (size_t)count, sizeof(pack_input_t), compare_inputs);
+
+    for (int file = 1; file < count; file++)
+    {
+        if (compare_inputs(&inputs[file - 1], &inputs[file]) == 0)
+        {
+            printf("%s was given more than once\n", inputs[file].entry.name);
+            goto cleanup;
+        }
+    }
+
+    names_offset = index_offset + (size_t)count * QOI_ARCHIVE_ENTRY_SIZE;
+    data_offset = align_up(names_offset + names_len);
+
+    /* Header, index and names are written in one go, the QOI files follow aligned */
+    table = (uint8_t*)calloc(data_offset, 1);
+    if (!table) goto cleanup;
+
+    write_qoi_archive_header(table, (uint32_t)count, index_offset, names_offset);
+
+    for (int file = 0; file < count; file++)
+    {
+        write_qoi_archive_entry(table + index_offset + (size_t)file * QOI_ARCHIVE_ENTRY_SIZE, &inputs[file].entry, data_offset, name_offset);
+        memcpy(table + names_offset + name_offset, inputs[file].entry.name, inputs[file].entry.name_len);
+
+        name_offset += (uint32_t)inputs[file].entry.name_len;
+        data_offset = align_up(data_offset + inputs[file].entry.len);
+    }
+
+    fp = fopen(path, "wb");
+
+    if (fp)
+    {
+        static const uint8_t zeros[QOI_ARCHIVE_ALIGN] = {0};
+        size_t written = align_up(names_offset + names_len);
+
+        fwrite(table, 1, written, fp);
+
+        for (int file = 0; file < count; file++)
+        {
+            fwrite(inputs[file].bytes, 1, inputs[file].entry.len, fp);
+            written += inputs[file].entry.len;
+
+            fwrite(zeros, 1, align_up(written) - written, fp);
+            written = align_up(written);
+        }
+
+        result = ferror(fp) ? 4 : 0;
+        fclose(fp);
+
+        printf("Packed %d %s into %s (%zu bytes)\n", count, (count > 1) ? "files" : "file", path, written);
+    }
+    else
+    {
+        printf("Cannot open %s\n", path);
+        result = 4;
+    }
+
+    free(table);
+
+cleanup:
+    for (int file = 0; file < count; file++)
+        free(inputs[file].bytes);
+
+    free(inputs);
+
+    return result;
+}
+
+#if defined(QOI_PACK_POSIX)
+/* Runs jobs on a few threads, each taking the next index until none are left */
+typedef struct
+{
+    qoi_job_t job;
+    void* arg;
+    size_t count, next;
+    pthread_mutex_t lock;
+} pack_parallel_t;
+
+static void* pack_worker(void* arg)
+{
+    pack_parallel_t* parallel = (pack_parallel_t*)arg;
+
+    for (;;)
+    {
+        size_t index;
+
+        pthread_mutex_lock(&parallel->lock);
+        index = parallel->next++;
+        pthread_mutex_unlock(&parallel->lock);
+
+        if (index >= parallel->count)
+            return NULL;
+
+        parallel->job(parallel->arg, index);
+    }
+}
+
+static void pack_parallel_for(qoi_job_t job, void* arg, size_t count, void* user)
+{
+    pack_parallel_t parallel;
+    pthread_t threads[QOI_PACK_THREADS];
+    int started = 0;
+
+    (void)user;
+
+    parallel.job = job;
+    parallel.arg = arg;
+    parallel.count = count;
+    parallel.next = 0;
+    pthread_mutex_init(&parallel.lock, NULL);
+
+    for (int thread = 0; thread < QOI_PACK_THREADS; thread++)
+    {
+        if (pthread_create(&threads[started], NULL, pack_worker, &parallel) == 0)
+            started++;
+    }
+
+    /* Finish on this thread if no thread could be started */
+    if (started == 0)
+        pack_worker(&parallel);
+
+    for (int thread = 0; thread < started; thread++)
+        pthread_join(threads[thread], NULL);
+
+    pthread_mutex_destroy(&parallel.lock);
+}
+#endif
+
+static int verify_archive(qoi_archive_t* archive)
+{
+    size_t count = archive->entry_count;
+    size_t* indices = (size_t*)calloc(count + 1, sizeof(size_t));
+    void** outputs = (void**)calloc(count + 1, sizeof(void*));
+    bool* status = (bool*)calloc(count + 1, sizeof(bool));
+    size_t failed = 0;
+    int result = 0;
+
+    if (!indices || !outputs || !status)
+    {
+        result = 3;
+        goto cleanup;
+    }
+
+    for (size_t index = 0; index < count; index++)
+    {
+        qoi_archive_entry_t entry;
+
+        indices[index] = index;
+
+        if (!qoi_archive_entry_at(archive, index, &entry))
+        {
+            printf("Entry %zu does not match its QOI header\n", index);
+            result = 1;
+            goto cleanup;
+        }
+
+        if (
+            entry.desc.channels < 3 || entry.desc.channels > 4 || entry.desc.height == 0 ||
+            entry.desc.width > (SIZE_MAX - 4) / entry.desc.height / entry.desc.channels
+        )
+        {
+            printf("Entry %.*s has invalid dimensions\n", (int)entry.name_len, entry.name);
+            result = 1;
+            goto cleanup;
+        }
+
+        outputs[index] = malloc((size_t)entry.desc.width * entry.desc.height * entry.desc.channels + 4);
+
+        if (!outputs[index])
+        {
+            result = 3;
+            goto cleanup;
+        }
+    }
+
+#if defined(QOI_PACK_POSIX)
+    qoi_archive_decode_batch(archive, indices, outputs, status, count, pack_parallel_for, NULL);
+#else
+    qoi_archive_decode_batch(archive, indices, outputs, status, count, NULL, NULL);
+#endif
+
+    for (size_t index = 0; index < count; index++)
+    {
+        if (!status[index])
+        {
+            qoi_archive_entry_t entry;
+
+            qoi_archive_entry_at(archive, index, &entry);
+            printf("Failed to decode %.*s\n", (int)entry.name_len, entry.name);
+            failed++;
+        }
+    }
+
+    printf("Decoded %zu of %zu entries\n", count - failed, count);
+
+    result = failed ? 1 : 0;
+
+cleanup:
+    if (outputs)
+    {
+        for (size_t index = 0; index < count; index++)
+            free(outputs[index]);
+    }
+
+    free(indices);
+    free(outputs);
+    free(status);
+
+    return result;
+}
+
+/* Writes pixels out as a QOI file */
+static int write_qoi_file(const char* path, qoi_desc_t* desc, const uint8_t* pixels)
+{
+    size_t len = qoi_encoded_size(desc, pixels);
+    uint8_t* qoi_file = (uint8_t*)malloc(len ? len : 1);
+    qoi_enc_t enc;
+    FILE* fp;
+    int result = 0;
+
+    if (!qoi_file) return 3;
+
+    write_qoi_header(desc, qoi_file);
+    qoi_enc_init(desc, &enc, qoi_file);
+
+    for (size_t seek = 0; !qoi_enc_done(&enc); seek += desc->channels)
+    {
+        qoi_pixel_t px;
+
+        qoi_set_pixel_rgba(&px, pixels[seek], pixels[seek + 1], pixels[seek + 2], (desc->channels > 3) ? pixels[seek + 3] : 255);
+        qoi_encode_pixel(desc, &enc, px);
+    }
+
+    fp = fopen(path, "wb");
+
+    if (fp)
+    {
+        fwrite(qoi_file, 1, len, fp);
+        result = ferror(fp) ? 4 : 0;
+        fclose(fp);
+    }
+    else
+    {
+        printf("Cannot open %s\n", path);
+        result = 4;
+    }
+
+    free(qoi_file);
+
+    return result;
+}
+
+/* Decodes a QOI file and encodes it again as a tiled container */
+static int create_tiled(const char* input, const char* output, uint32_t tile_size)
+{
+    size_t qoi_len, tiled_len, max_len;
+    uint8_t* qoi_file = read_file(input, &qoi_len);
+    uint8_t* pixels = NULL;
+    uint8_t* tiled = NULL;
+    qoi_desc_t desc;
+    qoi_dec_t dec;
+    FILE* fp;
+    int result = 1;
+
+    qoi_desc_init(&desc);
+
+    if (!qoi_file || qoi_len < 14 + 8 || !read_qoi_header(&desc, qoi_file) || desc.channels < 3 || desc.channels > 4)
+    {
+        printf("%s is not a QOIF file\n", input);
+        goto cleanup;
+    }
+
+    max_len = qoi_tiled_max_size(&desc, tile_size, tile_size);
+    pixels = (uint8_t*)malloc((size_t)desc.width * desc.height * desc.channels + 1);
+    tiled = (uint8_t*)malloc(max_len ? max_len : 1);
+
+    if (!pixels || !tiled || max_len == 0)
+    {
+        result = 3;
+        goto cleanup;
+    }
+
+    if (!qoi_dec_init(&desc, &dec, qoi_file, qoi_len) || !qoi_decode_pixels(&desc, &dec, pixels))
+    {
+        printf("%s is truncated\n", input);
+        goto cleanup;
+    }
+
+#if defined(QOI_PACK_POSIX)
+    tiled_len = qoi_tiled_encode(&desc, pixels, tile_size, tile_size, tiled, pack_parallel_for, NULL);
+#else
+    tiled_len = qoi_tiled_encode(&desc, pixels, tile_size, tile_size, tiled, NULL, NULL);
+#endif
+
+    fp = fopen(output, "wb");
+
+    if (fp)
+    {
+        fwrite(tiled, 1, tiled_len, fp);
+        result = ferror(fp) ? 4 : 0;
+        fclose(fp);
+
+        printf("Tiled %s into %ux%u tiles in %s (%zu bytes)\n", input, tile_size, tile_size, output, tiled_len);
+    }
+    else
+    {
+        printf("Cannot open %s\n", output);
+        result = 4;
+    }
+
+cleanup:
+    free(qoi_file);
+    free(pixels);
+    free(tiled);
+
+    return result;
+}
+
+/* Decodes a region of a tiled container into a QOI file */
+static int extract_region(qoi_tiled_t* tiled, uint32_t x, uint32_t y, uint32_t width, uint32_t height, const char* output)
+{
+    uint8_t* pixels = (uint8_t*)malloc((size_t)width * height * tiled->desc.channels + 1);
+    bool* status = (bool*)calloc(qoi_tiled_region_tiles(tiled, x, y, width, height) + 1, sizeof(bool));
+    qoi_desc_t desc;
+    bool decoded;
+    int result;
+
+    if (!pixels || !status)
+    {
+        free(pixels);
+        free(status);
+        return 3;
+    }
+
+#if defined(QOI_PACK_POSIX)
+    decoded = qoi_tiled_decode_region(tiled, x, y, width, height, pixels, status, pack_parallel_for, NULL);
+#else
+    decoded = qoi_tiled_decode_region(tiled, x, y, width, height, pixels, status, NULL, NULL);
+#endif
+
+    free(status);
+
+    if (!decoded)
+    {
+        printf("Cannot decode the region %ux%u at %u,%u\n", width, height, x, y);
+        free(pixels);
+        return 1;
+    }
+
+    qoi_desc_init(&desc);
+    qoi_set_dimensions(&desc, width, height);
+    qoi_set_channels(&desc, tiled->desc.channels);
+    qoi_set_colorspace(&desc, tiled->desc.colorspace);
+
+    result = write_qoi_file(output, &desc, pixels);
+
+    free(pixels);
+
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    mapped_file_t file;
+    qoi_archive_t archive;
+    int result = 0;
+
+    print_version();
+
+    if (argc < 3)
+    {
+        print_help();
+        return -1;
+    }
+
+    if (strcmp(argv[1], "create") == 0)
+    {
+        if (argc < 4)
+        {
+            print_help();
+            return -1;
+        }
+
+        return create_archive(argv[2], argc - 3, &argv[3]);
+    }
+
+    if (strcmp(argv[1], "tile") == 0)
+    {
+        uint32_t tile_size = (argc >= 5) ? (uint32_t)strtoul(argv[4], NULL, 10) : 256;
+
+        if (argc < 4 || tile_size == 0)
+        {
+            print_help();
+            return -1;
+        }
+
+        return create_tiled(argv[2], argv[3], tile_size);
+    }
+
+    if (!map_file(argv[2], &file))
+    {
+        printf("Cannot open %s\n", argv[2]);
+        print_help();
+        return -1;
+    }
+
+    if (strcmp(argv[1], "region") == 0)
+    {
+        qoi_tiled_t tiled;
+
+        if (argc < 8)
+        {
+            print_help();
+            result = -1;
+        }
+        else if (!qoi_tiled_open(&tiled, file.data, file.len))
+        {
+            printf("The file you opened is not a tiled QOI container\n");
+            result = 1;
+        }
+        else
+        {
+            result = extract_region(&tiled,
+                (uint32_t)strtoul(argv[3], NULL, 10), (uint32_t)strtoul(argv[4], NULL, 10),
+                (uint32_t)strtoul(argv[5], NULL, 10), (uint32_t)strtoul(argv[6], NULL, 10),
+                argv[7]);
+        }
+
+        unmap_file(&file);
+
+        return result;
+    }
+
+    if (!qoi_archive_open(&archive, file.data, file.len))
+    {
+        printf("The file you opened is not a QOI archive\n");
+        unmap_file(&file);
+        return 1;
+    }
+
+    if (strcmp(argv[1], "list") == 0)
+    {
+        for (size_t index = 0; index < archive.entry_count; index++)
+        {
+            qoi_archive_entry_t entry;
+
+            if (!qoi_archive_entry_at(&archive, index, &entry))
+            {
+                result = 1;
+                break;
+            }
+
+            printf("%.*s %ux%u %u channels %zu bytes\n",
+                (int)entry.name_len, entry.name,
+                entry.desc.width, entry.desc.height, entry.desc.channels, entry.len);
+        }
+    }
+    else if (strcmp(argv[1], "extract") == 0 && argc >= 5)
+    {
+        qoi_archive_entry_t entry;
+
+        if (qoi_archive_find(&archive, argv[3], strlen(argv[3]), &entry))
+        {
+            FILE* fp = fopen(argv[4], "wb");
+
+            if (fp)
+            {
+                /* Straight from the mapping without copying */
+                fwrite(entry.data, 1, entry.len, fp);
+                fclose(fp);
+            }
+            else
+            {
+                result = 4;
+            }
+        }
+        else
+        {
+            printf("%s is not in %s\n", argv[3], argv[2]);
+            result = 1;
+        }
+    }
+    else if (strcmp(argv[1], "verify") == 0)
+    {
+        result = verify_archive(&archive);
+    }
+    else
+    {
+        print_help();
+        result = -1;
+    }
+
+    unmap_file(&file);
+
+    return result;
+}
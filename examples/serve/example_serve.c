@@ -0,0 +1,1024 @@
+/*
+
+    -- example_serve.c -- Local QOI transcoding server using this library
+
+    -- version 1.1 -- revised 2026-10-18
+
+    -- Changelog --
+
+    - version 1.1 (2026-10-18)
+
+    Decoded images are limited to a configurable size and QOI files
+    that end before every pixel is decoded are refused
+
+    - version 1.0 (2026-10-18)
+
+    Serves over HTTP/1.1 on a localhost TCP port or a UNIX socket
+
+        POST /encode?width=W&height=H&channels=C&colorspace=S
+            raw RGB or RGBA body in, QOI file out
+        POST /decode
+            QOI file body in, raw RGB or RGBA out with the image
+            information in X-QOI-Width, X-QOI-Height, X-QOI-Channels
+            and X-QOI-Colorspace headers
+        GET /stats
+            JSON with request counts, cache hit rate and latency percentiles
+
+    Encoded results are kept in a size bounded LRU cache keyed by a
+    128-bit hash of the raw pixels and the image description.
+
+    MIT License
+
+    Copyright (c) 2024-2026 Aftersol
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+
+
+*/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define SIMPLIFIED_QOI_IMPLEMENTATION
+#include "sQOI.h"
+
+#define QOI_SERVE_MAX_HEADER 8192 /* Largest accepted request header */
+#define QOI_SERVE_MAX_BODY ((size_t)1 << 30) /* Largest accepted request body: 1 GiB */
+#define QOI_SERVE_MAX_RAW_MIB 64 /* Default largest decoded image */
+#define QOI_SERVE_LATENCY_SAMPLES 8192 /* Latencies kept for percentiles */
+
+const char version_number[] = "version 1.1";
+const char revised_date[] = "2026-10-18";
+
+void print_version()
+{
+    printf("QOI Server\nversion: %s -- revised %s\n", version_number, revised_date);
+}
+
+void print_help()
+{
+    printf("Example usage: qoi_serve <port or unix socket path> [worker threads] [cache size in MiB] [largest decoded image in MiB]\n");
+    printf("Endpoints:\n");
+    printf("POST /encode?width=W&height=H&channels=C&colorspace=S\n");
+    printf("POST /decode\n");
+    printf("GET /stats\n");
+}
+
+/* A client connection, owned by one worker at a time through EPOLLONESHOT */
+typedef struct
+{
+    int fd;
+    char* buffer;
+    size_t used, capacity;
+    size_t expected; /* Header and body length of the buffered request once its header is parsed, otherwise 0 */
+} connection_t;
+
+/* 128-bit content hash used as the cache key */
+typedef struct
+{
+    uint64_t low, high;
+} content_hash_t;
+
+typedef struct cache_entry
+{
+    content_hash_t key;
+    uint8_t* qoi_file;
+    size_t len;
+
+    struct cache_entry* lru_prev;
+    struct cache_entry* lru_next;
+    struct cache_entry* bucket_next;
+} cache_entry_t;
+
+/* Size bounded LRU cache of encoded results */
+typedef struct
+{
+    pthread_mutex_t lock;
+
+    cache_entry_t** buckets;
+    size_t bucket_count;
+
+    cache_entry_t* newest;
+    cache_entry_t* oldest;
+
+    size_t bytes, capacity;
+} lru_cache_t;
+
+/* Request counters and latency samples for /stats */
+typedef struct
+{
+    pthread_mutex_t lock;
+
+    uint64_t requests, encodes, decodes, errors;
+    uint64_t cache_hits, cache_misses;
+
+    uint32_t latency_us[QOI_SERVE_LATENCY_SAMPLES];
+    size_t latency_count, latency_next;
+} server_stats_t;
+
+static int listen_fd = -1;
+static int epoll_fd = -1;
+static lru_cache_t cache;
+static server_stats_t stats;
+static size_t max_raw_bytes = (size_t)QOI_SERVE_MAX_RAW_MIB << 20;
+
+static void* stdlib_malloc(size_t size, void* user)
+{
+    (void)user;
+    return malloc(size);
+}
+
+static void* stdlib_realloc(void* ptr, size_t size, void* user)
+{
+    (void)user;
+    return realloc(ptr, size);
+}
+
+static void stdlib_free(void* ptr, void* user)
+{
+    (void)user;
+    free(ptr);
+}
+
+static uint64_t now_us()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static uint64_t rotate_left(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+/* Two independent multiply-rotate lanes over the pixels, seeded with the image description */
+static content_hash_t hash_content(const qoi_desc_t* desc, const uint8_t* bytes, size_t len)
+{
+    content_hash_t hash;
+    uint64_t seed = ((uint64_t)desc->width << 32) ^ ((uint64_t)desc->height << 8) ^ ((uint64_t)desc->channels << 4) ^ desc->colorspace;
+    size_t seek;
+
+    hash.low = 0x9E3779B97F4A7C15ULL ^ seed;
+    hash.high = 0xC2B2AE3D27D4EB4FULL + seed;
+
+    for (seek = 0; seek + 8 <= len; seek += 8)
+    {
+        uint64_t word;
+
+        memcpy(&word, bytes + seek, 8);
+
+        hash.low = rotate_left((hash.low ^ word) * 0x87C37B91114253D5ULL, 31);
+        hash.high = rotate_left((hash.high + word) * 0x4CF5AD432745937FULL, 27) ^ hash.low;
+    }
+
+    for (; seek < len; seek++)
+    {
+        hash.low = rotate_left((hash.low ^ bytes[seek]) * 0x87C37B91114253D5ULL, 31);
+        hash.high = rotate_left((hash.high + bytes[seek]) * 0x4CF5AD432745937FULL, 27) ^ hash.low;
+    }
+
+    /* Finalize so the length and every input bit affect all output bits */
+    hash.low ^= len;
+    hash.high ^= hash.low;
+    hash.low ^= hash.low >> 33;
+    hash.low *= 0xFF51AFD7ED558CCDULL;
+    hash.low ^= hash.low >> 33;
+    hash.high ^= hash.high >> 29;
+    hash.high *= 0xC4CEB9FE1A85EC53ULL;
+    hash.high ^= hash.high >> 32;
+
+    return hash;
+}
+
+static bool cache_init(lru_cache_t* lru, size_t capacity)
+{
+    pthread_mutex_init(&lru->lock, NULL);
+
+    lru->bucket_count = 4096;
+    lru->buckets = (cache_entry_t**)calloc(lru->bucket_count, sizeof(cache_entry_t*));
+    lru->newest = NULL;
+    lru->oldest = NULL;
+    lru->bytes = 0;
+    lru->capacity = capacity;
+
+    return lru->buckets != NULL;
+}
+
+static void cache_unlink(lru_cache_t* lru, cache_entry_t* entry)
+{
+    if (entry->lru_prev) entry->lru_prev->lru_next = entry->lru_next;
+    else lru->newest = entry->lru_next;
+
+    if (entry->lru_next) entry->lru_next->lru_prev = entry->lru_prev;
+    else lru->oldest = entry->lru_prev;
+
+    entry->lru_prev = NULL;
+    entry->lru_next = NULL;
+}
+
+static void cache_push_newest(lru_cache_t* lru, cache_entry_t* entry)
+{
+    entry->lru_prev = NULL;
+    entry->lru_next = lru->newest;
+
+    if (lru->newest) lru->newest->lru_prev = entry;
+    else lru->oldest = entry;
+
+    lru->newest = entry;
+}
+
+static void cache_evict_oldest(lru_cache_t* lru)
+{
+    cache_entry_t* entry = lru->oldest;
+    cache_entry_t** link = &lru->buckets[entry->key.low % lru->bucket_count];
+
+    while (*link != entry)
+        link = &(*link)->bucket_next;
+
+    *link = entry->bucket_next;
+
+    cache_unlink(lru, entry);
+    lru->bytes -= entry->len;
+
+    free(entry->qoi_file);
+    free(entry);
+}
+
+/* Copies a cached QOI file out of the cache; the copy must be freed by the caller */
+static uint8_t* cache_lookup(lru_cache_t* lru, content_hash_t key, size_t* len)
+{
+    cache_entry_t* entry;
+    uint8_t* copy = NULL;
+
+    pthread_mutex_lock(&lru->lock);
+
+    for (entry = lru->buckets[key.low % lru->bucket_count]; entry; entry = entry->bucket_next)
+    {
+        if (entry->key.low == key.low && entry->key.high == key.high)
+            break;
+    }
+
+    if (entry)
+    {
+        cache_unlink(lru, entry);
+        cache_push_newest(lru, entry);
+
+        copy = (uint8_t*)malloc(entry->len);
+
+        if (copy)
+        {
+            memcpy(copy, entry->qoi_file, entry->len);
+            *len = entry->len;
+        }
+    }
+
+    pthread_mutex_unlock(&lru->lock);
+
+    return copy;
+}
+
+static void cache_insert(lru_cache_t* lru, content_hash_t key, const uint8_t* qoi_file, size_t len)
+{
+    cache_entry_t* entry;
+    size_t bucket = key.low % lru->bucket_count;
+
+    /* Results larger than a quarter of the cache would only thrash it */
+    if (len > lru->capacity / 4) return;
+
+    entry = (cache_entry_t*)calloc(1, sizeof(cache_entry_t));
+    if (!entry) return;
+
+    entry->qoi_file = (uint8_t*)malloc(len);
+    if (!entry->qoi_file)
+    {
+        free(entry);
+        return;
+    }
+
+    memcpy(entry->qoi_file, qoi_file, len);
+    entry->key = key;
+    entry->len = len;
+
+    pthread_mutex_lock(&lru->lock);
+
+    /* Another worker may have encoded the same image meanwhile */
+    for (cache_entry_t* existing = lru->buckets[bucket]; existing; existing = existing->bucket_next)
+    {
+        if (existing->key.low == key.low && existing->key.high == key.high)
+        {
+            pthread_mutex_unlock(&lru->lock);
+
+            free(entry->qoi_file);
+            free(entry);
+            return;
+        }
+    }
+
+    while (lru->oldest && lru->bytes + len > lru->capacity)
+        cache_evict_oldest(lru);
+
+    entry->bucket_next = lru->buckets[bucket];
+    lru->buckets[bucket] = entry;
+
+    cache_push_newest(lru, entry);
+    lru->bytes += len;
+
+    pthread_mutex_unlock(&lru->lock);
+}
+
+static void stats_record(uint64_t latency_us, bool ok)
+{
+    pthread_mutex_lock(&stats.lock);
+
+    stats.requests++;
+    if (!ok) stats.errors++;
+
+    stats.latency_us[stats.latency_next] = (latency_us > UINT32_MAX) ? UINT32_MAX : (uint32_t)latency_us;
+    stats.latency_next = (stats.latency_next + 1) % QOI_SERVE_LATENCY_SAMPLES;
+
+    if (stats.latency_count < QOI_SERVE_LATENCY_SAMPLES)
+        stats.latency_count++;
+
+    pthread_mutex_unlock(&stats.lock);
+}
+
+static int compare_u32(const void* a, const void* b)
+{
+    uint32_t left = *(const uint32_t*)a, right = *(const uint32_t*)b;
+
+    return (left > right) - (left < right);
+}
+
+/* Writes the /stats JSON document into text */
+static int stats_json(char* text, size_t size)
+{
+    static uint32_t sorted[QOI_SERVE_LATENCY_SAMPLES];
+    static pthread_mutex_t sorted_lock = PTHREAD_MUTEX_INITIALIZER;
+    uint32_t p50 = 0, p90 = 0, p99 = 0, max = 0;
+    uint64_t lookups;
+    double hit_rate;
+    size_t count, cache_bytes;
+    int written;
+
+    pthread_mutex_lock(&cache.lock);
+    cache_bytes = cache.bytes;
+    pthread_mutex_unlock(&cache.lock);
+
+    pthread_mutex_lock(&sorted_lock);
+    pthread_mutex_lock(&stats.lock);
+
+    count = stats.latency_count;
+    memcpy(sorted, stats.latency_us, count * sizeof(uint32_t));
+
+    lookups = stats.cache_hits + stats.cache_misses;
+    hit_rate = lookups ? (double)stats.cache_hits / (double)lookups : 0.0;
+
+    written = snprintf(text, size,
+        "{\"requests\": %llu, \"encodes\": %llu, \"decodes\": %llu, \"errors\": %llu, "
+        "\"cache\": {\"hits\": %llu, \"misses\": %llu, \"hit_rate\": %.4f, \"bytes\": %zu, \"capacity\": %zu}, ",
+        (unsigned long long)stats.requests,
+        (unsigned long long)stats.encodes,
+        (unsigned long long)stats.decodes,
+        (unsigned long long)stats.errors,
+        (unsigned long long)stats.cache_hits,
+        (unsigned long long)stats.cache_misses,
+        hit_rate,
+        cache_bytes,
+        cache.capacity
+        );
+
+    pthread_mutex_unlock(&stats.lock);
+
+    if (count > 0)
+    {
+        qsort(sorted, count, sizeof(uint32_t), compare_u32);
+
+        p50 = sorted[(count - 1) * 50 / 100];
+        p90 = sorted[(count - 1) * 90 / 100];
+        p99 = sorted[(count - 1) * 99 / 100];
+        max = sorted[count - 1];
+    }
+
+    pthread_mutex_unlock(&sorted_lock);
+
+    written += snprintf(text + written, size - written,
+        "\"latency_us\": {\"samples\": %zu, \"p50\": %u, \"p90\": %u, \"p99\": %u, \"max\": %u}}\n",
+        count, p50, p90, p99, max
+        );
+
+    return written;
+}
+
+/* Writes everything to a non-blocking socket, waiting whenever it is full */
+static bool send_all(int fd, const void* data, size_t len)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+
+    while (len > 0)
+    {
+        ssize_t sent = send(fd, bytes, len, MSG_NOSIGNAL);
+
+        if (sent > 0)
+        {
+            bytes += sent;
+            len -= (size_t)sent;
+        }
+        else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            struct pollfd pfd = {fd, POLLOUT, 0};
+
+            if (poll(&pfd, 1, 30000) <= 0) return false;
+        }
+        else if (sent < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool send_response(int fd, int status, const char* reason, const char* content_type, const char* extra_headers, const void* body, size_t len, bool keep_alive)
+{
+    char header[512];
+    int header_len = snprintf(header, sizeof(header),
+        "HTTP/1.1 %d %s\r\n"
+        "Content-Type: %s\r\n"
+        "Content-Length: %zu\r\n"
+        "%s"
+        "Connection: %s\r\n\r\n",
+        status, reason, content_type, len, extra_headers ? extra_headers : "", keep_alive ? "keep-alive" : "close"
+        );
+
+    if (!send_all(fd, header, (size_t)header_len)) return false;
+
+    return len == 0 || send_all(fd, body, len);
+}
+
+static bool send_error(int fd, int status, const char* reason, bool keep_alive)
+{
+    char body[128];
+    int len = snprintf(body, sizeof(body), "%d %s\n", status, reason);
+
+    return send_response(fd, status, reason, "text/plain", NULL, body, (size_t)len, keep_alive);
+}
+
+/* Finds the value of a query string parameter such as width=... */
+static bool query_param(const char* query, size_t query_len, const char* name, unsigned long* value)
+{
+    size_t name_len = strlen(name);
+    size_t seek = 0;
+
+    while (seek < query_len)
+    {
+        if (query_len - seek > name_len && strncmp(query + seek, name, name_len) == 0 && query[seek + name_len] == '=')
+        {
+            *value = strtoul(query + seek + name_len + 1, NULL, 10);
+            return true;
+        }
+
+        while (seek < query_len && query[seek] != '&') seek++;
+        seek++;
+    }
+
+    return false;
+}
+
+/* Finds the value of a header line, matching its name regardless of case */
+static const char* header_value(const char* headers, size_t len, const char* name)
+{
+    size_t name_len = strlen(name);
+    const char* line = headers;
+    const char* end = headers + len;
+
+    while (line < end)
+    {
+        const char* line_end = (const char*)memchr(line, '\n', (size_t)(end - line));
+
+        if (!line_end) break;
+
+        if ((size_t)(line_end - line) > name_len && strncasecmp(line, name, name_len) == 0 && line[name_len] == ':')
+        {
+            line += name_len + 1;
+
+            while (*line == ' ' || *line == '\t') line++;
+
+            return line;
+        }
+
+        line = line_end + 1;
+    }
+
+    return NULL;
+}
+
+static bool handle_encode(qoi_ctx_t* ctx, int fd, const char* query, size_t query_len, uint8_t* body, size_t body_len, bool keep_alive)
+{
+    unsigned long width = 0, height = 0, channels = 0, colorspace = 0;
+    content_hash_t key;
+    qoi_desc_t desc;
+    uint8_t* qoi_file;
+    size_t qoi_len;
+    bool sent;
+
+    if (
+        !query_param(query, query_len, "width", &width) ||
+        !query_param(query, query_len, "height", &height) ||
+        !query_param(query, query_len, "channels", &channels)
+    )
+    {
+        return send_error(fd, 400, "Bad Request", keep_alive);
+    }
+
+    query_param(query, query_len, "colorspace", &colorspace);
+
+    if (channels < 3 || channels > 4 || colorspace > 1 || width == 0 || height == 0 || width > UINT32_MAX || height > UINT32_MAX)
+        return send_error(fd, 400, "Bad Request", keep_alive);
+
+    if ((uint64_t)width * (uint64_t)height * channels != body_len)
+        return send_error(fd, 400, "Bad Request", keep_alive);
+
+    qoi_desc_init(&desc);
+    qoi_set_dimensions(&desc, (uint32_t)width, (uint32_t)height);
+    qoi_set_channels(&desc, (uint8_t)channels);
+    qoi_set_colorspace(&desc, (uint8_t)colorspace);
+
+    key = hash_content(&desc, body, body_len);
+    qoi_file = cache_lookup(&cache, key, &qoi_len);
+
+    pthread_mutex_lock(&stats.lock);
+    stats.encodes++;
+    if (qoi_file) stats.cache_hits++;
+    else stats.cache_misses++;
+    pthread_mutex_unlock(&stats.lock);
+
+    if (qoi_file)
+    {
+        sent = send_response(fd, 200, "OK", "image/qoi", "X-QOI-Cache: hit\r\n", qoi_file, qoi_len, keep_alive);
+        free(qoi_file);
+
+        return sent;
+    }
+
+    qoi_file = qoi_ctx_encode(ctx, &desc, body, &qoi_len);
+
+    if (!qoi_file)
+        return send_error(fd, 500, "Internal Server Error", keep_alive);
+
+    cache_insert(&cache, key, qoi_file, qoi_len);
+
+    return send_response(fd, 200, "OK", "image/qoi", "X-QOI-Cache: miss\r\n", qoi_file, qoi_len, keep_alive);
+}
+
+static bool handle_decode(qoi_ctx_t* ctx, int fd, uint8_t* body, size_t body_len, bool keep_alive)
+{
+    char extra_headers[256];
+    qoi_desc_t desc;
+    uint8_t* bytes;
+    size_t raw_len;
+
+    pthread_mutex_lock(&stats.lock);
+    stats.decodes++;
+    pthread_mutex_unlock(&stats.lock);
+
+    /* Check the header first so bogus dimensions cannot allocate huge buffers */
+    qoi_desc_init(&desc);
+
+    if (body_len < 14 + 8 || !read_qoi_header(&desc, body))
+        return send_error(fd, 400, "Bad Request", keep_alive);
+
+    if (desc.channels < 3 || desc.channels > 4 || desc.width == 0 || desc.height == 0)
+        return send_error(fd, 400, "Bad Request", keep_alive);
+
+    /* Each factor is checked on its own so the product cannot wrap */
+    if (desc.width > max_raw_bytes / desc.channels || desc.height > max_raw_bytes / desc.channels / desc.width)
+        return send_error(fd, 413, "Payload Too Large", keep_alive);
+
+    /* Fails on a truncated body too, so the pixels of an earlier request are never sent */
+    bytes = qoi_ctx_decode(ctx, body, body_len, &raw_len);
+
+    if (!bytes)
+        return send_error(fd, 400, "Bad Request", keep_alive);
+
+    snprintf(extra_headers, sizeof(extra_headers),
+        "X-QOI-Width: %u\r\nX-QOI-Height: %u\r\nX-QOI-Channels: %u\r\nX-QOI-Colorspace: %u\r\n",
+        ctx->desc.width, ctx->desc.height, ctx->desc.channels, ctx->desc.colorspace
+        );
+
+    return send_response(fd, 200, "OK", "application/octet-stream", extra_headers, bytes, raw_len, keep_alive);
+}
+
+static void close_connection(connection_t* conn)
+{
+    close(conn->fd);
+    free(conn->buffer);
+    free(conn);
+}
+
+/*
+    Handles every complete request buffered on a connection.
+    Returns false when the connection must be closed.
+*/
+static bool process_requests(qoi_ctx_t* ctx, connection_t* conn)
+{
+    for (;;)
+    {
+        char* header_end;
+        const char* value;
+        char method[8], target[1024];
+        const char* query;
+        size_t header_len, body_len = 0, query_len = 0, target_len;
+        bool keep_alive = true, ok;
+        uint64_t start;
+
+        conn->expected = 0;
+
+        header_end = (char*)memmem(conn->buffer, conn->used, "\r\n\r\n", 4);
+
+        if (!header_end)
+        {
+            if (conn->used > QOI_SERVE_MAX_HEADER)
+            {
+                send_error(conn->fd, 431, "Request Header Fields Too Large", false);
+                return false;
+            }
+
+            return true;
+        }
+
+        header_len = (size_t)(header_end - conn->buffer) + 4;
+
+        if (header_len > QOI_SERVE_MAX_HEADER)
+        {
+            send_error(conn->fd, 431, "Request Header Fields Too Large", false);
+            return false;
+        }
+
+        value = header_value(conn->buffer, header_len, "Content-Length");
+        if (value) body_len = strtoull(value, NULL, 10);
+
+        if (body_len > QOI_SERVE_MAX_BODY)
+        {
+            send_error(conn->fd, 413, "Payload Too Large", false);
+            return false;
+        }
+
+        /* Wait for the rest of the body */
+        conn->expected = header_len + body_len;
+
+        if (conn->used < conn->expected)
+            return true;
+
+        start = now_us();
+
+        value = header_value(conn->buffer, header_len, "Connection");
+        if (value && strncasecmp(value, "close", 5) == 0) keep_alive = false;
+
+        if (sscanf(conn->buffer, "%7s %1023s", method, target) != 2)
+        {
+            send_error(conn->fd, 400, "Bad Request", false);
+            return false;
+        }
+
+        target_len = strlen(target);
+        query = strchr(target, '?');
+
+        if (query)
+        {
+            target_len = (size_t)(query - target);
+            query_len = strlen(query + 1);
+            query++;
+        }
+        else
+        {
+            query = "";
+        }
+
+        if (strcmp(method, "POST") == 0 && target_len == 7 && strncmp(target, "/encode", 7) == 0)
+        {
+            ok = handle_encode(ctx, conn->fd, query, query_len, (uint8_t*)conn->buffer + header_len, body_len, keep_alive);
+        }
+        else if (strcmp(method, "POST") == 0 && target_len == 7 && strncmp(target, "/decode", 7) == 0)
+        {
+            ok = handle_decode(ctx, conn->fd, (uint8_t*)conn->buffer + header_len, body_len, keep_alive);
+        }
+        else if (strcmp(method, "GET") == 0 && target_len == 6 && strncmp(target, "/stats", 6) == 0)
+        {
+            char json[1024];
+            int len = stats_json(json, sizeof(json));
+
+            ok = send_response(conn->fd, 200, "OK", "application/json", NULL, json, (size_t)len, keep_alive);
+        }
+        else
+        {
+            ok = send_error(conn->fd, 404, "Not Found", keep_alive);
+        }
+
+        stats_record(now_us() - start, ok);
+
+        if (!ok || !keep_alive) return false;
+
+        /* Keep any pipelined request that followed this one */
+        memmove(conn->buffer, conn->buffer + header_len + body_len, conn->used - header_len - body_len);
+        conn->used -= header_len + body_len;
+    }
+}
+
+/*
+    Reads what is available on a connection. Returns false when the connection must be closed.
+    Reading stops once the buffered request is whole, or once more than a header's worth is
+    buffered without a parsed header, so process_requests can answer it before anything else
+    is read. A request whose length is known gets a buffer of that size in one step.
+*/
+static bool read_connection(connection_t* conn)
+{
+    for (;;)
+    {
+        ssize_t received;
+
+        if (conn->expected ? conn->used >= conn->expected : conn->used > QOI_SERVE_MAX_HEADER)
+            return true;
+
+        if (conn->capacity < conn->expected || conn->capacity == 0)
+        {
+            size_t capacity = (conn->expected > 65536 * 2) ? conn->expected : 65536 * 2;
+            char* buffer;
+
+            buffer = (char*)realloc(conn->buffer, capacity + 1);
+            if (!buffer) return false;
+
+            conn->buffer = buffer;
+            conn->capacity = capacity;
+        }
+
+        received = recv(conn->fd, conn->buffer + conn->used, conn->capacity - conn->used, 0);
+
+        if (received > 0)
+        {
+            conn->used += (size_t)received;
+            conn->buffer[conn->used] = '\0';
+        }
+        else if (received == 0)
+        {
+            return false;
+        }
+        else if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            return true;
+        }
+        else if (errno != EINTR)
+        {
+            return false;
+        }
+    }
+}
+
+static void accept_connections()
+{
+    for (;;)
+    {
+        struct epoll_event event;
+        connection_t* conn;
+        int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+        if (fd < 0) return;
+
+        conn = (connection_t*)calloc(1, sizeof(connection_t));
+        if (!conn)
+        {
+            close(fd);
+            continue;
+        }
+
+        conn->fd = fd;
+
+        /* One shot so only one worker handles a connection at a time */
+        event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+        event.data.ptr = conn;
+
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0)
+            close_connection(conn);
+    }
+}
+
+/* Every worker waits on the same epoll instance and serves whatever becomes ready */
+static void* worker_main(void* arg)
+{
+    struct epoll_event events[16];
+    qoi_allocator_t allocator = {stdlib_malloc, stdlib_realloc, stdlib_free, NULL};
+    qoi_ctx_t ctx;
+
+    (void)arg;
+
+    qoi_ctx_init(&ctx, &allocator);
+
+    for (;;)
+    {
+        int ready = epoll_wait(epoll_fd, events, 16, -1);
+
+        for (int event = 0; event < ready; event++)
+        {
+            connection_t* conn = (connection_t*)events[event].data.ptr;
+
+            if (conn == NULL)
+            {
+                accept_connections();
+                continue;
+            }
+
+            if (read_connection(conn) && process_requests(&ctx, conn))
+            {
+                struct epoll_event rearm;
+
+                rearm.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+                rearm.data.ptr = conn;
+
+                if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, conn->fd, &rearm) == 0)
+                    continue;
+            }
+
+            close_connection(conn);
+        }
+    }
+
+    qoi_ctx_destroy(&ctx);
+
+    return NULL;
+}
+
+/* Listens on 127.0.0.1 when given a port number or on a UNIX socket when given a path */
+static int open_listener(const char* address)
+{
+    int fd;
+
+    if (strchr(address, '/'))
+    {
+        struct sockaddr_un addr;
+
+        if (strlen(address) >= sizeof(addr.sun_path)) return -1;
+
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strcpy(addr.sun_path, address);
+
+        unlink(address);
+
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+
+        if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+        {
+            close(fd);
+            return -1;
+        }
+    }
+    else
+    {
+        struct sockaddr_in addr;
+        int reuse = 1;
+        unsigned long port = strtoul(address, NULL, 10);
+
+        if (port == 0 || port > 65535) return -1;
+
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((uint16_t)port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+        {
+            close(fd);
+            return -1;
+        }
+    }
+
+    if (listen(fd, SOMAXCONN) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+int main(int argc, char* argv[])
+{
+    struct epoll_event event;
+    pthread_t* workers;
+    unsigned long worker_count = 4, cache_mib = 64, raw_mib = QOI_SERVE_MAX_RAW_MIB;
+
+    print_version();
+
+    if (argc < 2 || strlen(argv[1]) <= 0)
+    {
+        print_help();
+        return -1;
+    }
+
+    if (argc > 2) worker_count = strtoul(argv[2], NULL, 0);
+    if (argc > 3) cache_mib = strtoul(argv[3], NULL, 0);
+    if (argc > 4) raw_mib = strtoul(argv[4], NULL, 0);
+
+    if (worker_count == 0 || worker_count > 256)
+    {
+        printf("Worker threads must be between 1 and 256\n");
+        print_help();
+        return -1;
+    }
+
+    if (raw_mib == 0 || raw_mib > (QOI_SERVE_MAX_BODY >> 20) * 4)
+    {
+        printf("Largest decoded image must be between 1 and %lu MiB\n", (unsigned long)(QOI_SERVE_MAX_BODY >> 20) * 4);
+        print_help();
+        return -1;
+    }
+
+    max_raw_bytes = (size_t)raw_mib << 20;
+
+    signal(SIGPIPE, SIG_IGN);
+
+    pthread_mutex_init(&stats.lock, NULL);
+
+    if (!cache_init(&cache, (size_t)cache_mib << 20))
+        return 1;
+
+    listen_fd = open_listener(argv[1]);
+
+    if (listen_fd < 0)
+    {
+        printf("Cannot listen on %s\n", argv[1]);
+        print_help();
+        return -1;
+    }
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0)
+        return 1;
+
+    /* The listener is marked by a NULL pointer; exclusive so a new client wakes one worker */
+    event.events = EPOLLIN | EPOLLEXCLUSIVE;
+    event.data.ptr = NULL;
+
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event) < 0)
+        return 1;
+
+    workers = (pthread_t*)calloc(worker_count, sizeof(pthread_t));
+    if (!workers)
+        return 1;
+
+    printf("Serving on %s with %lu workers, a %lu MiB cache and decoded images up to %lu MiB\n", argv[1], worker_count, cache_mib, raw_mib);
+    fflush(stdout);
+
+    for (unsigned long worker = 0; worker < worker_count; worker++)
+        pthread_create(&workers[worker], NULL, worker_main, NULL);
+
+    for (unsigned long worker = 0; worker < worker_count; worker++)
+        pthread_join(workers[worker], NULL);
+
+    free(workers);
+
+    return 0;
+}
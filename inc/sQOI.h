@@ -84,6 +84,21 @@
 
 #ifdef SIMPLIFIED_QOI_IMPLEMENTATION
 
+/* Hardware CRC32C: SSE4.2 on x86 or the CRC extension on ARM */
+#if defined(__SSE4_2__) || (defined(_MSC_VER) && defined(__AVX__))
+#define QOI_CRC32C_SSE42
+#include <nmmintrin.h>
+#elif defined(__ARM_FEATURE_CRC32)
+#define QOI_CRC32C_ARM
+#include <arm_acle.h>
+#endif
+
+/* The decode-ahead ring needs C11 atomics; C++ code can use std::atomic around the decoder instead */
+#if !defined(__cplusplus) && defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)
+#define QOI_RING_AVAILABLE
+#include <stdatomic.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -108,6 +123,13 @@ extern "C" {
 enum qoi_pixel_color {QOI_RED, QOI_GREEN, QOI_BLUE, QOI_ALPHA};
 enum qoi_channels {QOI_WHITESPACE = 3, QOI_TRANSPARENT = 4};
 enum qoi_colorspace {QOI_SRGB, QOI_LINEAR};
+enum qoi_float_format {QOI_FLOAT32, QOI_FLOAT16};
+enum qoi_planar_type {QOI_PLANAR_U8, QOI_PLANAR_F32};
+enum qoi_endian {QOI_LITTLE_ENDIAN, QOI_BIG_ENDIAN};
+enum qoi_reduce {QOI_REDUCE_TRUNCATE, QOI_REDUCE_ROUND, QOI_REDUCE_DITHER};
+enum qoi_yuv_format {QOI_YUV_I420, QOI_YUV_NV12, QOI_YUV_YUYV};
+enum qoi_yuv_matrix {QOI_YUV_BT601, QOI_YUV_BT709};
+enum qoi_yuv_range {QOI_YUV_LIMITED, QOI_YUV_FULL};
 
 /* QOI magic number */
 static const uint8_t QOI_MAGIC[4] = {'q', 'o', 'i', 'f'};
@@ -115,6 +137,32 @@ static const uint8_t QOI_MAGIC[4] = {'q', 'o', 'i', 'f'};
 /* QOI end of file */
 static const uint8_t QOI_PADDING[8] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01};
 
+/* QOI archive magic number and layout */
+static const uint8_t QOI_ARCHIVE_MAGIC[4] = {'q', 'o', 'i', 'a'};
+
+#define QOI_ARCHIVE_VERSION 1
+#define QOI_ARCHIVE_HEADER_SIZE 32
+#define QOI_ARCHIVE_ENTRY_SIZE 40
+#define QOI_ARCHIVE_ALIGN 64 /* QOI files start on cache line boundaries */
+
+/* QOI tiled container magic number and layout */
+static const uint8_t QOI_TILED_MAGIC[4] = {'q', 'o', 'i', 't'};
+
+#define QOI_TILED_VERSION 1
+#define QOI_TILED_HEADER_SIZE 32
+#define QOI_TILED_ALIGN 4 /* the QOI header of every tile is read with 32-bit loads */
+
+/* Optional checksum trailer placed after QOI_PADDING; decoders stop at the padding and ignore it */
+static const uint8_t QOI_HASH_MAGIC[4] = {'q', 'c', 's', 'c'};
+
+#define QOI_HASH_TRAILER_SIZE 12
+
+/* Saved encoder state used to resume an unfinished QOI file */
+static const uint8_t QOI_ENC_STATE_MAGIC[4] = {'q', 'o', 'i', 'e'};
+
+#define QOI_ENC_STATE_VERSION 1
+#define QOI_ENC_STATE_SIZE 300
+
 /* QOI descriptor as read by the header */
 typedef struct
 {
@@ -180,6 +228,314 @@ typedef struct
     uint32_t pad : 24;
 } qoi_dec_t;
 
+/* Chunk used between two palette colors in qoi_palette_t.ops */
+#define QOI_PALETTE_OP_RGB  0x0000
+#define QOI_PALETTE_OP_RGBA 0x0001
+
+/*
+    Palette prepared for encoding 8-bit color indices. ops holds, for every pair
+    of previous and current palette colors, the DIFF or LUMA chunk bytes (first
+    byte in the high 8 bits) or QOI_PALETTE_OP_RGB / QOI_PALETTE_OP_RGBA when
+    neither fits. It takes about 130 KiB so keep it static or allocate it.
+*/
+typedef struct
+{
+    qoi_pixel_t colors[256];
+    uint8_t index_position[256];
+
+    uint16_t count;
+
+    uint16_t ops[256][256];
+} qoi_palette_t;
+
+/*
+    A YUV frame converted to RGB while it is encoded. Fill in the planes
+    and strides (bytes between rows) after qoi_yuv_init:
+
+    QOI_YUV_I420: planes[0] is Y, planes[1] is U and planes[2] is V,
+                  both with a sample for every 2x2 pixels
+    QOI_YUV_NV12: planes[0] is Y and planes[1] is interleaved U and V
+                  with a pair for every 2x2 pixels
+    QOI_YUV_YUYV: planes[0] holds Y0 U Y1 V for every two pixels of a row
+*/
+typedef struct
+{
+    const uint8_t* planes[3];
+    size_t strides[3];
+
+    uint8_t format;
+
+    /* Luma offset and 16.16 fixed point factors for luma, V to red, U and V to green and U to blue */
+    int32_t luma_offset;
+    int32_t factors[5];
+} qoi_yuv_t;
+
+/* Planar (CHW) output format shared by every image decoded with it */
+typedef struct
+{
+    /* Normalized float value of every 8-bit value for each channel */
+    float lut[4][256];
+
+    size_t plane_stride; /* elements between the start of two planes */
+
+    uint8_t type; /* QOI_PLANAR_U8 or QOI_PLANAR_F32 */
+    uint8_t channels; /* 3 drops the alpha plane, 4 keeps it */
+} qoi_planar_t;
+
+/* A batch of same sized images decoded into one NCHW tensor */
+typedef struct
+{
+    const qoi_planar_t* planar;
+
+    void* tensor; /* count * channels * plane_stride elements */
+
+    void** data; /* QOI file of each image */
+    size_t* len; /* length of each QOI file */
+    bool* status; /* set to whether each image decoded */
+
+    size_t count;
+    uint32_t width, height;
+} qoi_planar_batch_t;
+
+/*
+    Runs job(arg, index) for every index below count, possibly in parallel.
+    Plug a thread pool in here; a NULL hook runs jobs one after another.
+*/
+typedef void (*qoi_job_t)(void* arg, size_t index);
+typedef void (*qoi_parallel_for_t)(qoi_job_t job, void* arg, size_t count, void* user);
+
+/*
+    QOI archive: many QOI files in one file meant to be memory mapped
+
+    qoi_archive_header {
+        char magic[4]; // magic bytes "qoia"
+        uint32_t version; // QOI_ARCHIVE_VERSION
+        uint32_t entry_count;
+        uint32_t flags; // 0
+        uint64_t index_offset; // start of the entry table
+        uint64_t names_offset; // start of the entry names
+    };
+
+    qoi_archive_index_entry { // sorted by name hash, then by name
+        uint64_t name_hash; // qoi_archive_hash of the name
+        uint64_t data_offset; // QOI file, aligned to QOI_ARCHIVE_ALIGN
+        uint64_t data_len;
+        uint32_t name_offset; // relative to names_offset
+        uint16_t name_len;
+        uint8_t channels;
+        uint8_t colorspace;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    All values are little endian.
+*/
+typedef struct
+{
+    const uint8_t* data;
+    size_t len;
+    uint32_t entry_count;
+    const uint8_t* index;
+    const char* names;
+} qoi_archive_t;
+
+/* An archive entry pointing straight into the archive without copying */
+typedef struct
+{
+    const uint8_t* data; /* QOI file ready for qoi_dec_init */
+    size_t len;
+    const char* name; /* not null terminated */
+    size_t name_len;
+    qoi_desc_t desc;
+} qoi_archive_entry_t;
+
+/*
+    QOI tiled container: one large image split into tiles that are each a
+    complete QOI file, so any region can be decoded from the tiles it touches
+
+    qoi_tiled_header {
+        char magic[4]; // magic bytes "qoit"
+        uint32_t version; // QOI_TILED_VERSION
+        uint32_t width; // whole image
+        uint32_t height;
+        uint32_t tile_width; // tiles on the right and bottom edges may be smaller
+        uint32_t tile_height;
+        uint8_t channels;
+        uint8_t colorspace;
+        uint16_t flags; // 0
+        uint32_t reserved; // 0
+    };
+
+    uint64_t tile_offsets[tile_count + 1]; // tile n is the bytes from tile_offsets[n] up to tile_offsets[n + 1]
+
+    Tiles are stored left to right, then top to bottom, each starting on a
+    QOI_TILED_ALIGN byte boundary. All values are little endian.
+*/
+typedef struct
+{
+    const uint8_t* data;
+    size_t len;
+    qoi_desc_t desc; /* the whole image */
+    uint32_t tile_width, tile_height;
+    uint32_t tiles_x, tiles_y; /* tiles across and down */
+    const uint8_t* offsets;
+} qoi_tiled_t;
+
+/*
+    Allocator hooks for the parts of this library that own memory. realloc_fn
+    may be NULL, in which case a growing buffer is allocated again with
+    malloc_fn, its contents are copied and the old one goes to free_fn.
+*/
+typedef struct
+{
+    void* (*malloc_fn)(size_t size, void* user);
+    void* (*realloc_fn)(void* ptr, size_t size, void* user);
+    void (*free_fn)(void* ptr, void* user);
+    void* user;
+} qoi_allocator_t;
+
+/* A reusable buffer rounded up to a power of two size class */
+typedef struct
+{
+    uint8_t* data;
+    size_t capacity;
+} qoi_buffer_t;
+
+/*
+    Reusable codec context owning its input and output buffers and
+    encoder and decoder state. Keep one per thread; none of it is shared.
+*/
+typedef struct
+{
+    qoi_desc_t desc;
+    qoi_enc_t enc;
+    qoi_dec_t dec;
+
+    qoi_buffer_t input;
+    qoi_buffer_t output;
+
+    qoi_allocator_t allocator;
+} qoi_ctx_t;
+
+/* Mip levels encoded at once by qoi_mip_t; 16 levels cover images up to 32768 pixels across */
+#ifndef QOI_MIP_MAX_LEVELS
+#define QOI_MIP_MAX_LEVELS 16
+#endif
+
+/*
+    Encodes an image and its 2x box downsampled mip levels in one pass over
+    the source rows. Level n + 1 is half of level n rounding up, with partial
+    boxes on the right and bottom edges averaged over the pixels they cover.
+*/
+typedef struct
+{
+    qoi_desc_t desc[QOI_MIP_MAX_LEVELS];
+    qoi_enc_t enc[QOI_MIP_MAX_LEVELS];
+
+    uint32_t* accum[QOI_MIP_MAX_LEVELS]; /* box sums of the row being built, 4 per pixel; none for level 0 */
+    uint32_t rows[QOI_MIP_MAX_LEVELS]; /* rows encoded so far */
+    size_t capacity[QOI_MIP_MAX_LEVELS]; /* bytes allocated for the QOI file of each level */
+
+    uint8_t levels;
+
+    qoi_allocator_t allocator;
+} qoi_mip_t;
+
+/* A rectangle of pixels that changed since the previous frame */
+typedef struct
+{
+    uint32_t x, y, width, height;
+} qoi_rect_t;
+
+/* Encoder state at the start of a row and where the row starts in the QOI file */
+typedef struct
+{
+    qoi_pixel_t buffer[64];
+    qoi_pixel_t prev_pixel;
+    uint8_t run;
+    size_t offset;
+
+    /* Index slots the row's chunks look up before writing them, and the slots they write */
+    uint64_t reads, writes;
+} qoi_row_state_t;
+
+/*
+    Re-encodes frames of the same size touching only the rows that changed.
+    The QOI file and the state at the start of every row of the last frame
+    are kept, so the old bytes of unchanged rows can be copied over.
+*/
+typedef struct
+{
+    qoi_desc_t desc;
+
+    qoi_row_state_t* rows; /* height + 1 entries; the last one is the end of the file */
+    uint8_t* qoi_file; /* last frame */
+    uint8_t* spare; /* next frame */
+    size_t len, capacity, spare_capacity;
+    bool encoded; /* qoi_file holds a frame */
+
+    qoi_allocator_t allocator;
+} qoi_delta_t;
+
+/*
+    Running CRC32C checksums kept alongside an encoder or decoder.
+    qoi_crc covers every byte of the QOI file up to and including QOI_PADDING
+    and pixel_crc covers the raw pixels with desc->channels bytes each.
+*/
+typedef struct
+{
+    uint32_t qoi_crc;
+    uint32_t pixel_crc;
+
+    const uint8_t* hashed; /* QOI bytes before this pointer are in qoi_crc */
+} qoi_hash_t;
+
+/* Statistics of an image gathered by qoi_analyze straight from its chunks */
+typedef struct
+{
+    uint64_t histogram[4][256]; /* pixels with each value of red, green, blue and alpha */
+    uint64_t sums[4]; /* sum of every channel over the image */
+    uint64_t pixel_count;
+
+    /* Box around every pixel with alpha above zero; right and bottom are exclusive */
+    uint32_t alpha_left, alpha_top, alpha_right, alpha_bottom;
+    bool visible; /* false if every pixel is fully transparent and the box is empty */
+
+    bool solid; /* every pixel is first_pixel */
+    qoi_pixel_t first_pixel;
+} qoi_stats_t;
+
+#ifdef QOI_RING_AVAILABLE
+/*
+    Single producer, single consumer ring of row batches for decoding ahead:
+    one thread runs qoi_ring_produce while another takes the rows with
+    qoi_ring_acquire and hands the batch back with qoi_ring_release.
+    Neither side takes a lock; a full or empty ring waits through wait_fn.
+*/
+typedef struct
+{
+    qoi_desc_t* desc;
+    qoi_dec_t* dec;
+
+    uint8_t* rows; /* slots batches of rows_per_slot rows */
+    size_t slot_size;
+    uint32_t slots, rows_per_slot;
+    size_t batches; /* batches in the whole image */
+
+    void (*wait_fn)(void* user); /* called while waiting, such as to yield; NULL spins */
+    void* user;
+
+    atomic_bool failed;
+
+    /* The producer and consumer counters live on their own cache lines */
+    uint8_t head_line[64];
+    atomic_size_t head; /* batches published by the producer */
+    uint8_t tail_line[64];
+    atomic_size_t tail; /* batches released by the consumer */
+    uint8_t end_line[64];
+} qoi_ring_t;
+#endif
+
 /* Machine specific code */
 
 static inline uint32_t qoi_get_be32(uint32_t value);
@@ -211,6 +567,11 @@ bool qoi_enc_init(qoi_desc_t* desc, qoi_enc_t* enc, void* data);
 bool qoi_enc_done(qoi_enc_t* enc);
 
 void qoi_encode_chunk(qoi_desc_t *desc, qoi_enc_t *enc, void *qoi_pixel_bytes);
+void qoi_encode_pixel(qoi_desc_t *desc, qoi_enc_t *enc, qoi_pixel_t cur_pixel);
+void qoi_encode_chunk16(qoi_desc_t *desc, qoi_enc_t *enc, void *qoi_pixel_words, uint8_t endian, uint8_t reduce);
+void qoi_encode_chunk_near_lossless(qoi_desc_t *desc, qoi_enc_t *enc, void *qoi_pixel_bytes, const uint8_t bound[4]);
+void qoi_encode_chunk_branchless(qoi_desc_t *desc, qoi_enc_t *enc, void *qoi_pixel_bytes);
+void qoi_encode_pixel_branchless(qoi_desc_t *desc, qoi_enc_t *enc, qoi_pixel_t cur_pixel);
 
 static inline void qoi_enc_rgb(qoi_enc_t *enc, qoi_pixel_t px);
 static inline void qoi_enc_rgba(qoi_enc_t *enc, qoi_pixel_t px);
@@ -219,6 +580,71 @@ static inline void qoi_enc_index(qoi_enc_t *enc, uint8_t index_pos);
 static inline void qoi_enc_diff(qoi_enc_t *enc, uint8_t red_diff, uint8_t green_diff, uint8_t blue_diff);
 static inline void qoi_enc_luma(qoi_enc_t *enc, uint8_t green_diff, uint8_t dr_dg, uint8_t db_dg);
 static inline void qoi_enc_run(qoi_enc_t *enc);
+static inline void qoi_enc_padding(qoi_enc_t *enc);
+
+/* QOI indexed color encoder functions */
+
+bool qoi_palette_init(qoi_palette_t* palette, qoi_desc_t* desc, const void* colors, uint16_t count);
+void qoi_encode_indexed(qoi_desc_t* desc, qoi_enc_t* enc, const qoi_palette_t* palette, const uint8_t* indices, size_t count);
+
+/* QOI YUV encoder functions */
+
+bool qoi_yuv_init(qoi_yuv_t* yuv, uint8_t format, uint8_t matrix, uint8_t range);
+bool qoi_encode_yuv(qoi_desc_t* desc, qoi_enc_t* enc, const qoi_yuv_t* yuv);
+
+/* QOI mip pyramid encoder functions */
+
+uint8_t qoi_mip_max_levels(qoi_desc_t* desc);
+bool qoi_mip_init(qoi_mip_t* mip, qoi_desc_t* desc, uint8_t levels, const qoi_allocator_t* allocator);
+bool qoi_mip_push_row(qoi_mip_t* mip, const void* row);
+const uint8_t* qoi_mip_level(const qoi_mip_t* mip, uint8_t level, qoi_desc_t* desc, size_t* len);
+void qoi_mip_destroy(qoi_mip_t* mip);
+
+/* QOI dirty rectangle encoder functions */
+
+bool qoi_delta_init(qoi_delta_t* delta, qoi_desc_t* desc, const qoi_allocator_t* allocator);
+const uint8_t* qoi_delta_encode(qoi_delta_t* delta, const void* prev_frame, const void* frame, const qoi_rect_t* dirty, size_t dirty_count, size_t* len);
+void qoi_delta_destroy(qoi_delta_t* delta);
+
+/* QOI reusable context functions */
+
+bool qoi_ctx_init(qoi_ctx_t* ctx, const qoi_allocator_t* allocator);
+void qoi_ctx_trim(qoi_ctx_t* ctx);
+void qoi_ctx_destroy(qoi_ctx_t* ctx);
+
+uint8_t* qoi_ctx_input(qoi_ctx_t* ctx, size_t size);
+uint8_t* qoi_ctx_output(qoi_ctx_t* ctx, size_t size);
+
+uint8_t* qoi_ctx_encode(qoi_ctx_t* ctx, qoi_desc_t* desc, void* pixels, size_t* len);
+uint8_t* qoi_ctx_decode(qoi_ctx_t* ctx, void* data, size_t len, size_t* raw_len);
+
+/* QOI one-shot functions */
+
+size_t qoi_encoded_size(qoi_desc_t* desc, const void* pixels);
+void* qoi_encode_image(qoi_desc_t* desc, const void* pixels, size_t* len, const qoi_allocator_t* allocator);
+void* qoi_decode_image(qoi_desc_t* desc, const void* data, size_t len, const qoi_allocator_t* allocator);
+
+/* QOI archive functions */
+
+uint64_t qoi_archive_hash(const char* name, size_t name_len);
+
+bool qoi_archive_open(qoi_archive_t* archive, const void* data, size_t len);
+bool qoi_archive_entry_at(const qoi_archive_t* archive, size_t index, qoi_archive_entry_t* entry);
+bool qoi_archive_find(const qoi_archive_t* archive, const char* name, size_t name_len, qoi_archive_entry_t* entry);
+bool qoi_archive_decode_batch(const qoi_archive_t* archive, const size_t* indices, void** outputs, bool* status, size_t count, qoi_parallel_for_t parallel_for, void* user);
+
+void write_qoi_archive_header(void* dest, uint32_t entry_count, uint64_t index_offset, uint64_t names_offset);
+void write_qoi_archive_entry(void* dest, const qoi_archive_entry_t* entry, uint64_t data_offset, uint32_t name_offset);
+
+/* QOI tiled container functions */
+
+size_t qoi_tiled_max_size(qoi_desc_t* desc, uint32_t tile_width, uint32_t tile_height);
+size_t qoi_tiled_encode(qoi_desc_t* desc, const void* pixels, uint32_t tile_width, uint32_t tile_height, void* dest, qoi_parallel_for_t parallel_for, void* user);
+
+bool qoi_tiled_open(qoi_tiled_t* tiled, const void* data, size_t len);
+bool qoi_tiled_tile(const qoi_tiled_t* tiled, uint32_t tile_x, uint32_t tile_y, qoi_desc_t* desc, const uint8_t** data, size_t* len);
+size_t qoi_tiled_region_tiles(const qoi_tiled_t* tiled, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+bool qoi_tiled_decode_region(const qoi_tiled_t* tiled, uint32_t x, uint32_t y, uint32_t width, uint32_t height, void* out, bool* status, qoi_parallel_for_t parallel_for, void* user);
 
 /* QOI decoder functions */
 
@@ -226,6 +652,10 @@ bool qoi_dec_init(qoi_desc_t* desc, qoi_dec_t* dec, void* data, size_t len);
 bool qoi_dec_done(qoi_dec_t* dec);
 
 qoi_pixel_t qoi_decode_chunk(qoi_dec_t* dec);
+bool qoi_decode_pixels(qoi_desc_t* desc, qoi_dec_t* dec, void* out);
+
+size_t qoi_inplace_size(qoi_desc_t* desc, size_t qoi_len);
+bool qoi_decode_inplace(qoi_desc_t* desc, void* buffer, size_t buffer_len, size_t qoi_len);
 
 static inline void qoi_dec_rgb(qoi_dec_t* dec);
 static inline void qoi_dec_rgba(qoi_dec_t* dec);
@@ -234,6 +664,60 @@ static inline void qoi_dec_index(qoi_dec_t* dec, uint8_t tag);
 static inline void qoi_dec_diff(qoi_dec_t* dec, uint8_t tag);
 static inline void qoi_dec_luma(qoi_dec_t* dec, uint8_t tag);
 static inline void qoi_dec_run(qoi_dec_t* dec, uint8_t tag);
+static inline size_t qoi_dec_take_run(qoi_dec_t* dec);
+
+/* QOI downscaled thumbnail decoder functions */
+
+bool qoi_thumb_dimensions(qoi_desc_t* desc, uint8_t scale, uint32_t* width, uint32_t* height);
+size_t qoi_thumb_accum_size(qoi_desc_t* desc, uint8_t scale);
+bool qoi_decode_thumbnail(qoi_desc_t* desc, qoi_dec_t* dec, uint8_t scale, uint32_t* accum, void* out);
+
+/* QOI analysis functions */
+
+bool qoi_analyze(qoi_desc_t* desc, qoi_dec_t* dec, qoi_stats_t* stats);
+qoi_pixel_t qoi_stats_average(const qoi_stats_t* stats);
+
+/* QOI floating point decoder functions */
+
+bool qoi_decode_float(qoi_desc_t* desc, qoi_dec_t* dec, uint8_t format, void* out);
+
+/* QOI planar decoder functions */
+
+bool qoi_planar_init(qoi_planar_t* planar, uint8_t type, uint8_t channels, size_t plane_stride);
+void qoi_planar_normalize(qoi_planar_t* planar, const float mean[4], const float std[4]);
+bool qoi_decode_planar(qoi_desc_t* desc, qoi_dec_t* dec, const qoi_planar_t* planar, void* dest);
+bool qoi_decode_planar_batch(qoi_planar_batch_t* batch, qoi_parallel_for_t parallel_for, void* user);
+
+/* QOI checksum functions */
+
+uint32_t qoi_crc32c(uint32_t crc, const void* data, size_t len);
+
+void qoi_hash_init(qoi_hash_t* hash);
+void qoi_encode_chunk_hashed(qoi_desc_t* desc, qoi_enc_t* enc, qoi_hash_t* hash, void* qoi_pixel_bytes);
+qoi_pixel_t qoi_decode_chunk_hashed(qoi_desc_t* desc, qoi_dec_t* dec, qoi_hash_t* hash);
+bool qoi_decode_pixels_hashed(qoi_desc_t* desc, qoi_dec_t* dec, qoi_hash_t* hash, void* out);
+
+void write_qoi_hash_trailer(const qoi_hash_t* hash, void* dest);
+bool read_qoi_hash_trailer(qoi_hash_t* hash, const void* data, size_t len);
+
+/* QOI encoder state functions */
+
+void write_qoi_enc_state(const qoi_desc_t* desc, const qoi_enc_t* enc, void* dest);
+bool read_qoi_enc_state(qoi_desc_t* desc, qoi_enc_t* enc, const void* state, void* data);
+bool qoi_enc_extend(qoi_desc_t* desc, qoi_enc_t* enc, uint32_t height, void* data);
+bool qoi_enc_finish(qoi_desc_t* desc, qoi_enc_t* enc);
+
+#ifdef QOI_RING_AVAILABLE
+/* QOI decode-ahead ring functions */
+
+size_t qoi_ring_buffer_size(qoi_desc_t* desc, uint32_t slots, uint32_t rows_per_slot);
+bool qoi_ring_init(qoi_ring_t* ring, qoi_desc_t* desc, qoi_dec_t* dec, void* buffer, uint32_t slots, uint32_t rows_per_slot, void (*wait_fn)(void* user), void* user);
+
+void qoi_ring_produce(qoi_ring_t* ring);
+const uint8_t* qoi_ring_acquire(qoi_ring_t* ring, uint32_t* first_row, uint32_t* row_count);
+void qoi_ring_release(qoi_ring_t* ring);
+bool qoi_ring_failed(qoi_ring_t* ring);
+#endif
 
 /* Extract a 32-bit big endian integer regardless of endianness */
 static inline uint32_t qoi_get_be32(uint32_t value)
@@ -262,6 +746,48 @@ static inline uint32_t qoi_to_be32(uint32_t value)
     return *((uint32_t*)bytes);
 }
 
+#ifdef QOI_USE_SWAR
+
+/*
+    SWAR (SIMD within a register) kernels for cores with wide integer registers
+    but no SIMD unit. They work on concatenated_pixel_values as four byte lanes
+    whose positions follow the byte order of the host.
+*/
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define QOI_SWAR_RED   24
+#define QOI_SWAR_GREEN 16
+#define QOI_SWAR_BLUE  8
+
+/* Hash weights 11, 5, 7 and 3 for the lanes holding alpha, green, blue and red */
+#define QOI_SWAR_HASH 0x000B000500070003ULL
+#else
+#define QOI_SWAR_RED   0
+#define QOI_SWAR_GREEN 8
+#define QOI_SWAR_BLUE  16
+
+/* Hash weights 3, 7, 5 and 11 for the lanes holding red, blue, green and alpha */
+#define QOI_SWAR_HASH 0x000300070005000BULL
+#endif
+
+#define QOI_SWAR_HIGH 0x80808080u
+
+/* Sets the same byte in the red, green and blue lanes */
+#define QOI_SWAR_RGB(value) (((uint32_t)(value) << QOI_SWAR_RED) | ((uint32_t)(value) << QOI_SWAR_GREEN) | ((uint32_t)(value) << QOI_SWAR_BLUE))
+
+/* Adds each byte lane separately, wrapping around like uint8_t */
+static inline uint32_t qoi_swar_add(uint32_t a, uint32_t b)
+{
+    return ((a & ~QOI_SWAR_HIGH) + (b & ~QOI_SWAR_HIGH)) ^ ((a ^ b) & QOI_SWAR_HIGH);
+}
+
+/* Subtracts each byte lane separately, wrapping around like uint8_t */
+static inline uint32_t qoi_swar_sub(uint32_t a, uint32_t b)
+{
+    return ((a | QOI_SWAR_HIGH) - (b & ~QOI_SWAR_HIGH)) ^ ((a ^ ~b) & QOI_SWAR_HIGH);
+}
+
+#endif /* QOI_USE_SWAR */
+
 /* Compares two pixels for the same color */
 static bool qoi_cmp_pixel(qoi_pixel_t pixel1, qoi_pixel_t pixel2, const uint8_t channels)
 {
@@ -302,7 +828,18 @@ void qoi_initalize_pixel(qoi_pixel_t* pixel)
 /* Hashing function for pixels: up to 64 possible hash values */
 static inline int32_t qoi_get_index_position(qoi_pixel_t pixel)
 {
+#ifdef QOI_USE_SWAR
+    /*
+        Spread the four bytes into 16-bit lanes so one multiply adds up every
+        weighted channel in the top lane without carries between lanes
+    */
+    uint64_t value = pixel.concatenated_pixel_values;
+    uint64_t lanes = (value & 0x00FF00FF) | ((value & 0xFF00FF00) << 24);
+
+    return (int32_t)(((lanes * QOI_SWAR_HASH) >> 48) & 63);
+#else
     return (pixel.red * 3 + pixel.green * 5 + pixel.blue * 7 + pixel.alpha * 11) % 64;
+#endif
 }
 
 /* Initalize the QOI desciptor to the default value */
@@ -395,7 +932,7 @@ bool qoi_enc_init(qoi_desc_t* desc, qoi_enc_t* enc, void* data)
     if (enc == NULL || desc == NULL || data == NULL) return false;
 
     for (uint8_t element = 0; element < 64; element++)
-        qoi_initalize_pixel(&enc->buffer[element]); /* Initalize all the pixels in the buffer to zero for each channel of each pixels */
+        enc->buffer[element].concatenated_pixel_values = 0; /* Initalize all the pixels in the buffer to zero for each channel of each pixels */
 
     enc->len = (size_t)desc->width * (size_t)desc->height;
 
@@ -432,7 +969,7 @@ bool qoi_dec_init(qoi_desc_t* desc, qoi_dec_t* dec, void* data, size_t len)
         values is maintained by the encoder and decoder. 
     */
     for (uint8_t element = 0; element < 64; element++)
-        qoi_initalize_pixel(&dec->buffer[element]);
+        dec->buffer[element].concatenated_pixel_values = 0;
 
     qoi_set_pixel_rgba(&dec->prev_pixel, 0, 0, 0, 255);
     
@@ -456,357 +993,3803 @@ bool qoi_dec_done(qoi_dec_t* dec)
     return (dec->offset - dec->data > dec->qoi_len - 8) || (dec->pixel_seek >= dec->img_area); /* Has the decoder decoded all the pixels yet or reached the end of the file? */
 }
 
-/* Place the RGB information into the QOI file */
-static inline void qoi_enc_rgb(qoi_enc_t *enc, qoi_pixel_t px)
+/* Smallest size class handed out by qoi_ctx_t buffers: 4 KiB */
+#ifndef QOI_CTX_MIN_CLASS
+#define QOI_CTX_MIN_CLASS 4096
+#endif
+
+/*
+    Grows a buffer taken from the allocator to at least size bytes, keeping its
+    first used bytes. The capacity doubles so a buffer that fills up a little
+    at a time is only moved a few times. On failure the buffer is left as it
+    was and false is returned.
+*/
+static bool qoi_buffer_grow(const qoi_allocator_t* allocator, uint8_t** data, size_t* capacity, size_t used, size_t size)
 {
-    uint8_t tag[4] = {
-        QOI_OP_RGB,
-        px.red,
-        px.green,
-        px.blue
-    };
+    size_t new_capacity = (*capacity > 0) ? *capacity : size;
+    uint8_t* grown;
 
-    enc->offset[0] = tag[0]; /* RGB opcode */
-    enc->offset[1] = tag[1]; /* Red */
-    enc->offset[2] = tag[2]; /* Green */
-    enc->offset[3] = tag[3]; /* Blue */
+    if (size <= *capacity) return true;
 
-    enc->offset += 4;
-}
+    while (new_capacity < size)
+        new_capacity = (new_capacity > (size_t)-1 / 2) ? size : new_capacity * 2;
 
-/* Place the RGBA information into the QOI file */
-static inline void qoi_enc_rgba(qoi_enc_t *enc, qoi_pixel_t px)
-{
-    uint8_t tag[5] =
+    if (*data != NULL && allocator->realloc_fn != NULL)
     {
-        QOI_OP_RGBA,
-        px.red,
-        px.green,
-        px.blue,
-        px.alpha
-    };
+        grown = (uint8_t*)allocator->realloc_fn(*data, new_capacity, allocator->user);
+    }
+    else
+    {
+        grown = (uint8_t*)allocator->malloc_fn(new_capacity, allocator->user);
 
-    enc->offset[0] = tag[0]; /* RGBA opcode */
-    enc->offset[1] = tag[1]; /* Red */
-    enc->offset[2] = tag[2]; /* Green */
-    enc->offset[3] = tag[3]; /* Blue */
-    enc->offset[4] = tag[4]; /* Alpha */
+        if (grown != NULL && *data != NULL)
+        {
+            for (size_t seek = 0; seek < used; seek++)
+                grown[seek] = (*data)[seek];
 
-    enc->offset += 5;
-}
+            allocator->free_fn(*data, allocator->user);
+        }
+    }
 
-/* Place the index position of the buffer into the QOI file */
-static inline void qoi_enc_index(qoi_enc_t *enc, uint8_t index_pos)
-{
-    /* The run-length is stored with a bias of -1 */
-    uint8_t tag = QOI_OP_INDEX | index_pos;
-    enc->offset++[0] = tag;
-}
+    if (grown == NULL) return false;
 
-/* Place the differences between color values into the QOI file */
-static inline void qoi_enc_diff(qoi_enc_t *enc, uint8_t red_diff, uint8_t green_diff, uint8_t blue_diff)
-{
-    uint8_t tag =
-        QOI_OP_DIFF |
-        (uint8_t)(red_diff + 2) << 4 |
-        (uint8_t)(green_diff + 2) << 2 |
-        (uint8_t)(blue_diff + 2);
+    *data = grown;
+    *capacity = new_capacity;
 
-        enc->offset[0] = tag;
-        
-        enc->offset++;
+    return true;
 }
 
-/* Place the luma values into the QOI file */
-static inline void qoi_enc_luma(qoi_enc_t *enc, uint8_t green_diff, uint8_t dr_dg, uint8_t db_dg)
+/* Makes room for size more bytes after the offset of an encoder writing into a buffer taken from the allocator */
+static bool qoi_enc_reserve(const qoi_allocator_t* allocator, qoi_enc_t* enc, size_t* capacity, size_t size)
 {
-    uint8_t tag[2] = {
-        QOI_OP_LUMA | (uint8_t)(green_diff + 32), 
-        (uint8_t)(dr_dg + 8) << 4 | (uint8_t)(db_dg + 8)
-    };
+    size_t used = (size_t)(enc->offset - enc->data);
+    uint8_t* data = enc->data;
 
-    enc->offset[0] = tag[0];
-    enc->offset[1] = tag[1];
+    if (size <= *capacity - used) return true;
+    if (size > (size_t)-1 - used || !qoi_buffer_grow(allocator, &data, capacity, used, used + size)) return false;
 
-    enc->offset += 2;
+    enc->data = data;
+    enc->offset = data + used;
+
+    return true;
 }
 
-/* Place the run length of a pixel color information into the QOI file */
-static inline void qoi_enc_run(qoi_enc_t *enc)
+/* Make sure a context buffer holds at least size bytes, reusing it when it already does */
+static uint8_t* qoi_ctx_reserve(qoi_ctx_t* ctx, qoi_buffer_t* buffer, size_t size)
 {
-    /* The run-length is stored with a bias of -1 */
-    uint8_t tag = QOI_OP_RUN | (enc->run - 1);
-    enc->run = 0;
-    
-    enc->offset++[0] = tag;
-}
+    size_t capacity = QOI_CTX_MIN_CLASS;
+    uint8_t* data;
 
-/* 
+    if (buffer->data != NULL && buffer->capacity >= size)
+        return buffer->data;
+
+    /* Round up to the next size class so slightly larger images reuse it later */
+    while (capacity < size)
+    {
+        if (capacity > (size_t)-1 / 2) return NULL;
+        capacity *= 2;
+    }
+
+    /* realloc_fn may grow the buffer in place; without it the old contents are not needed so free and allocate rather than copy */
+    if (buffer->data != NULL && ctx->allocator.realloc_fn != NULL)
+    {
+        data = (uint8_t*)ctx->allocator.realloc_fn(buffer->data, capacity, ctx->allocator.user);
+
+        /* The old buffer is still there when it could not grow */
+        if (data == NULL) return NULL;
+    }
+    else
+    {
+        if (buffer->data != NULL)
+            ctx->allocator.free_fn(buffer->data, ctx->allocator.user);
+
+        data = (uint8_t*)ctx->allocator.malloc_fn(capacity, ctx->allocator.user);
+    }
+
+    buffer->data = data;
+    buffer->capacity = (data != NULL) ? capacity : 0;
+
+    return data;
+}
+
+/* Initalize a reusable codec context which allocates through the given hooks */
+bool qoi_ctx_init(qoi_ctx_t* ctx, const qoi_allocator_t* allocator)
+{
+    if (ctx == NULL || allocator == NULL) return false;
+    if (allocator->malloc_fn == NULL || allocator->free_fn == NULL) return false;
+
+    qoi_desc_init(&ctx->desc);
+
+    ctx->input.data = NULL;
+    ctx->input.capacity = 0;
+    ctx->output.data = NULL;
+    ctx->output.capacity = 0;
+
+    ctx->allocator = *allocator;
+
+    return true;
+}
+
+/* Give the buffers of a context back to its allocator; they are allocated again on next use */
+void qoi_ctx_trim(qoi_ctx_t* ctx)
+{
+    if (ctx == NULL) return;
+
+    if (ctx->input.data != NULL)
+        ctx->allocator.free_fn(ctx->input.data, ctx->allocator.user);
+
+    if (ctx->output.data != NULL)
+        ctx->allocator.free_fn(ctx->output.data, ctx->allocator.user);
+
+    ctx->input.data = NULL;
+    ctx->input.capacity = 0;
+    ctx->output.data = NULL;
+    ctx->output.capacity = 0;
+}
+
+/* Free everything owned by a context */
+void qoi_ctx_destroy(qoi_ctx_t* ctx)
+{
+    qoi_ctx_trim(ctx);
+}
+
+/* Get the input buffer of a context holding at least size bytes, e.g. to read a file into */
+uint8_t* qoi_ctx_input(qoi_ctx_t* ctx, size_t size)
+{
+    if (ctx == NULL) return NULL;
+
+    return qoi_ctx_reserve(ctx, &ctx->input, size);
+}
+
+/* Get the output buffer of a context holding at least size bytes */
+uint8_t* qoi_ctx_output(qoi_ctx_t* ctx, size_t size)
+{
+    if (ctx == NULL) return NULL;
+
+    return qoi_ctx_reserve(ctx, &ctx->output, size);
+}
+
+/* Loads a pixel of desc->channels bytes without reading past the last byte of the image */
+static inline qoi_pixel_t qoi_load_pixel(const uint8_t* bytes, uint8_t channels)
+{
+    qoi_pixel_t px;
+
+    qoi_set_pixel_rgba(&px, bytes[0], bytes[1], bytes[2], (channels > 3) ? bytes[3] : 255);
+
+    return px;
+}
+
+/*
+    Encodes an image into the output buffer of the context.
+    Returns the QOI file and sets len to its length or returns NULL on failure.
+    The result stays valid until the output buffer of the context is used again.
+*/
+uint8_t* qoi_ctx_encode(qoi_ctx_t* ctx, qoi_desc_t* desc, void* pixels, size_t* len)
+{
+    uint8_t* pixel_seek = (uint8_t*)pixels;
+    uint8_t* qoi_file;
+    size_t pixel_count;
+
+    if (ctx == NULL || desc == NULL || pixels == NULL || len == NULL) return NULL;
+    if (desc->channels < 3 || desc->channels > 4) return NULL;
+
+    pixel_count = (size_t)desc->width * (size_t)desc->height;
+
+    if (pixel_count == 0 || pixel_count > ((size_t)-1 - 14 - 8) / ((size_t)desc->channels + 1)) return NULL;
+
+    qoi_file = qoi_ctx_output(ctx, pixel_count * ((size_t)desc->channels + 1) + 14 + 8);
+
+    if (qoi_file == NULL) return NULL;
+
+    ctx->desc = *desc;
+
+    write_qoi_header(&ctx->desc, qoi_file);
+
+    if (!qoi_enc_init(&ctx->desc, &ctx->enc, qoi_file)) return NULL;
+
+    /* qoi_encode_chunk loads 4 bytes, which for RGB reads one byte past the last pixel */
+    while (ctx->enc.pixel_offset + 1 < ctx->enc.len)
+    {
+        qoi_encode_chunk(&ctx->desc, &ctx->enc, pixel_seek);
+        pixel_seek += ctx->desc.channels;
+    }
+
+    qoi_encode_pixel(&ctx->desc, &ctx->enc, qoi_load_pixel(pixel_seek, ctx->desc.channels));
+
+    *len = (size_t)(ctx->enc.offset - ctx->enc.data);
+
+    return qoi_file;
+}
+
+/*
+    Decodes a QOI file into the output buffer of the context; data may be the input buffer of the context.
+    Returns the raw pixels and sets raw_len to their length or returns NULL on failure.
+    The header read from the file is kept in ctx->desc.
+*/
+uint8_t* qoi_ctx_decode(qoi_ctx_t* ctx, void* data, size_t len, size_t* raw_len)
+{
+    uint8_t* bytes;
+
+    if (ctx == NULL || data == NULL || raw_len == NULL || len < 14 + 8) return NULL;
+
+    qoi_desc_init(&ctx->desc);
+
+    if (!read_qoi_header(&ctx->desc, data)) return NULL;
+    if (ctx->desc.channels < 3 || ctx->desc.channels > 4 || ctx->desc.width == 0 || ctx->desc.height == 0) return NULL;
+    if (ctx->desc.width > (size_t)-1 / ctx->desc.height / ctx->desc.channels) return NULL;
+
+    *raw_len = (size_t)ctx->desc.width * (size_t)ctx->desc.height * (size_t)ctx->desc.channels;
+
+    bytes = qoi_ctx_output(ctx, *raw_len);
+
+    if (bytes == NULL || !qoi_dec_init(&ctx->desc, &ctx->dec, data, len)) return NULL;
+
+    /* A truncated stream would leave the bytes of the last image behind */
+    if (!qoi_decode_pixels(&ctx->desc, &ctx->dec, bytes)) return NULL;
+
+    return bytes;
+}
+
+/*
+    Counts the exact length of the QOI file for an image, header and padding
+    included, without storing it. The encoder runs as usual but its output
+    goes to a small scratch buffer that is reused for every pixel.
+    Returns 0 if desc is not a valid image.
+*/
+size_t qoi_encoded_size(qoi_desc_t* desc, const void* pixels)
+{
+    const uint8_t* pixel_seek = (const uint8_t*)pixels;
+    uint8_t scratch[16]; /* A run and an RGBA chunk or the padding at most */
+    qoi_enc_t enc;
+    size_t size = 14;
+
+    if (desc == NULL || pixels == NULL || desc->channels < 3 || desc->channels > 4) return 0;
+
+    /* An image without pixels is not a valid QOI image */
+    if (desc->width == 0 || desc->height == 0) return 0;
+
+    if (!qoi_enc_init(desc, &enc, scratch)) return 0;
+
+    while (!qoi_enc_done(&enc))
+    {
+        enc.offset = scratch;
+
+        qoi_encode_pixel(desc, &enc, qoi_load_pixel(pixel_seek, desc->channels));
+        pixel_seek += desc->channels;
+
+        size += (size_t)(enc.offset - scratch);
+    }
+
+    return size;
+}
+
+/*
+    Encodes an image into a buffer of exactly the right size taken from the allocator.
+    Returns the QOI file, which the caller frees through the allocator, and sets len
+    to its length, or returns NULL on failure.
+*/
+void* qoi_encode_image(qoi_desc_t* desc, const void* pixels, size_t* len, const qoi_allocator_t* allocator)
+{
+    const uint8_t* pixel_seek = (const uint8_t*)pixels;
+    uint8_t* qoi_file;
+    qoi_enc_t enc;
+    size_t size;
+
+    if (len == NULL || allocator == NULL || allocator->malloc_fn == NULL) return NULL;
+
+    size = qoi_encoded_size(desc, pixels);
+
+    if (size == 0) return NULL;
+
+    qoi_file = (uint8_t*)allocator->malloc_fn(size, allocator->user);
+
+    if (qoi_file == NULL) return NULL;
+
+    write_qoi_header(desc, qoi_file);
+
+    if (!qoi_enc_init(desc, &enc, qoi_file))
+    {
+        if (allocator->free_fn) allocator->free_fn(qoi_file, allocator->user);
+        return NULL;
+    }
+
+    while (!qoi_enc_done(&enc))
+    {
+        qoi_encode_pixel(desc, &enc, qoi_load_pixel(pixel_seek, desc->channels));
+        pixel_seek += desc->channels;
+    }
+
+    *len = size;
+
+    return qoi_file;
+}
+
+/*
+    Decodes a whole QOI file into a buffer of width * height * channels bytes taken
+    from the allocator. desc receives the header. Returns the pixels, which the caller
+    frees through the allocator, or NULL if the file is invalid or truncated.
+*/
+void* qoi_decode_image(qoi_desc_t* desc, const void* data, size_t len, const qoi_allocator_t* allocator)
+{
+    uint8_t* pixels;
+    qoi_dec_t dec;
+    size_t raw_len;
+
+    if (desc == NULL || data == NULL || len < 14 + 8 || allocator == NULL || allocator->malloc_fn == NULL) return NULL;
+
+    qoi_desc_init(desc);
+
+    if (!read_qoi_header(desc, (void*)data)) return NULL;
+    if (desc->channels < 3 || desc->channels > 4 || desc->width == 0 || desc->height == 0) return NULL;
+    if (desc->width > (size_t)-1 / desc->height / desc->channels) return NULL;
+
+    raw_len = (size_t)desc->width * (size_t)desc->height * (size_t)desc->channels;
+
+    pixels = (uint8_t*)allocator->malloc_fn(raw_len, allocator->user);
+
+    if (pixels == NULL) return NULL;
+
+    if (!qoi_dec_init(desc, &dec, (void*)data, len) || !qoi_decode_pixels(desc, &dec, pixels))
+    {
+        if (allocator->free_fn) allocator->free_fn(pixels, allocator->user);
+        return NULL;
+    }
+
+    return pixels;
+}
+
+/* Place the RGB information into the QOI file */
+static inline void qoi_enc_rgb(qoi_enc_t *enc, qoi_pixel_t px)
+{
+    uint8_t tag[4] = {
+        QOI_OP_RGB,
+        px.red,
+        px.green,
+        px.blue
+    };
+
+    enc->offset[0] = tag[0]; /* RGB opcode */
+    enc->offset[1] = tag[1]; /* Red */
+    enc->offset[2] = tag[2]; /* Green */
+    enc->offset[3] = tag[3]; /* Blue */
+
+    enc->offset += 4;
+}
+
+/* Place the RGBA information into the QOI file */
+static inline void qoi_enc_rgba(qoi_enc_t *enc, qoi_pixel_t px)
+{
+    uint8_t tag[5] =
+    {
+        QOI_OP_RGBA,
+        px.red,
+        px.green,
+        px.blue,
+        px.alpha
+    };
+
+    enc->offset[0] = tag[0]; /* RGBA opcode */
+    enc->offset[1] = tag[1]; /* Red */
+    enc->offset[2] = tag[2]; /* Green */
+    enc->offset[3] = tag[3]; /* Blue */
+    enc->offset[4] = tag[4]; /* Alpha */
+
+    enc->offset += 5;
+}
+
+/* Place the index position of the buffer into the QOI file */
+static inline void qoi_enc_index(qoi_enc_t *enc, uint8_t index_pos)
+{
+    /* The run-length is stored with a bias of -1 */
+    uint8_t tag = QOI_OP_INDEX | index_pos;
+    enc->offset++[0] = tag;
+}
+
+/* Place the differences between color values into the QOI file */
+static inline void qoi_enc_diff(qoi_enc_t *enc, uint8_t red_diff, uint8_t green_diff, uint8_t blue_diff)
+{
+    uint8_t tag =
+        QOI_OP_DIFF |
+        (uint8_t)(red_diff + 2) << 4 |
+        (uint8_t)(green_diff + 2) << 2 |
+        (uint8_t)(blue_diff + 2);
+
+        enc->offset[0] = tag;
+        
+        enc->offset++;
+}
+
+/* Place the luma values into the QOI file */
+static inline void qoi_enc_luma(qoi_enc_t *enc, uint8_t green_diff, uint8_t dr_dg, uint8_t db_dg)
+{
+    uint8_t tag[2] = {
+        (uint8_t)(QOI_OP_LUMA | (uint8_t)(green_diff + 32)),
+        (uint8_t)((uint8_t)(dr_dg + 8) << 4 | (uint8_t)(db_dg + 8))
+    };
+
+    enc->offset[0] = tag[0];
+    enc->offset[1] = tag[1];
+
+    enc->offset += 2;
+}
+
+/* Place the QOI padding marking the end of the file */
+static inline void qoi_enc_padding(qoi_enc_t *enc)
+{
+    enc->offset[0] = QOI_PADDING[0];
+    enc->offset[1] = QOI_PADDING[1];
+    enc->offset[2] = QOI_PADDING[2];
+    enc->offset[3] = QOI_PADDING[3];
+    enc->offset[4] = QOI_PADDING[4];
+    enc->offset[5] = QOI_PADDING[5];
+    enc->offset[6] = QOI_PADDING[6];
+    enc->offset[7] = QOI_PADDING[7];
+
+    enc->offset += 8;
+}
+
+/* Place the run length of a pixel color information into the QOI file */
+static inline void qoi_enc_run(qoi_enc_t *enc)
+{
+    /* The run-length is stored with a bias of -1 */
+    uint8_t tag = QOI_OP_RUN | (enc->run - 1);
+    enc->run = 0;
+    
+    enc->offset++[0] = tag;
+}
+
+/* 
     WARNING: In this function below, you must provide enough memory to put the encoded images 
     The safest amount of space to store encoded images is the equation below
 
-    (image width) * (image height) * ((amount of channels in a pixel) + 1) = bytes required to store encoded image
-*/
+    (image width) * (image height) * ((amount of channels in a pixel) + 1) + 14 + 8 = bytes required to store encoded image
+
+    qoi_encoded_size() gives the exact amount when the whole image is available up front
+*/
+
+void qoi_encode_chunk(qoi_desc_t *desc, qoi_enc_t *enc, void *qoi_pixel_bytes)
+{
+
+    /* 
+        Assume that the pixel byte order is the following below
+        bytes[0] = red;
+        bytes[1] = green;
+        bytes[2] = blue;
+        bytes[3] = alpha;
+    */
+
+    qoi_encode_pixel(desc, enc, *((qoi_pixel_t*)qoi_pixel_bytes));
+}
+
+/* 4x4 ordered dithering thresholds */
+static const uint8_t QOI_BAYER_4X4[4][4] = {
+    { 0,  8,  2, 10},
+    {12,  4, 14,  6},
+    { 3, 11,  1,  9},
+    {15,  7, 13,  5}
+};
+
+/* Reduce a 16-bit sample to 8 bits; threshold is only used by QOI_REDUCE_DITHER */
+static inline uint8_t qoi_reduce16(uint16_t value, uint8_t reduce, uint8_t threshold)
+{
+    uint32_t scaled;
+
+    switch (reduce)
+    {
+        case QOI_REDUCE_ROUND:
+            return (uint8_t)(((uint32_t)value * 255 + 32767) / 65535);
+        case QOI_REDUCE_DITHER:
+        {
+            /* Offset by the threshold in sixteenths of a step instead of half a step */
+            scaled = ((uint32_t)value * 255 + ((uint32_t)threshold * 2 + 1) * 65535 / 32) / 65535;
+            return (uint8_t)((scaled > 255) ? 255 : scaled);
+        }
+        default:
+            return (uint8_t)(value >> 8);
+    }
+}
+
+/*
+    Encodes a pixel of 16-bit samples reducing them to 8 bits on the fly, so
+    high bit depth images need no 8-bit copy. Samples are little or big endian
+    by endian and reduced by truncation, rounding or 4x4 ordered dithering of
+    the color channels by reduce. The result only depends on the pixel position.
+*/
+void qoi_encode_chunk16(qoi_desc_t *desc, qoi_enc_t *enc, void *qoi_pixel_words, uint8_t endian, uint8_t reduce)
+{
+    uint8_t* bytes = (uint8_t*)qoi_pixel_words;
+    uint8_t threshold = 0;
+    qoi_pixel_t cur_pixel;
+
+    /* Position inside the dither matrix */
+    if (reduce == QOI_REDUCE_DITHER && desc->width > 0)
+    {
+        size_t x = enc->pixel_offset % desc->width;
+        size_t y = enc->pixel_offset / desc->width;
+
+        threshold = QOI_BAYER_4X4[y & 3][x & 3];
+    }
+
+    cur_pixel.alpha = 255;
+
+    for (uint8_t channel = 0; channel < desc->channels && channel < 4; channel++)
+    {
+        uint16_t value = (endian == QOI_BIG_ENDIAN) ?
+            (uint16_t)((bytes[channel * 2] << 8) | bytes[channel * 2 + 1]) :
+            (uint16_t)(bytes[channel * 2] | (bytes[channel * 2 + 1] << 8));
+
+        /* Dithering alpha would make flat transparency noisy so it is rounded */
+        if (channel == QOI_ALPHA && reduce == QOI_REDUCE_DITHER)
+            cur_pixel.channels[channel] = qoi_reduce16(value, QOI_REDUCE_ROUND, 0);
+        else
+            cur_pixel.channels[channel] = qoi_reduce16(value, reduce, threshold);
+    }
+
+    qoi_encode_pixel(desc, enc, cur_pixel);
+}
+
+/* Is a reconstructed channel value within bound of the source value without wrapping around? */
+static inline bool qoi_within_bound(int32_t value, uint8_t source, uint8_t bound)
+{
+    return value >= 0 && value <= 255 && value - source <= bound && source - value <= bound;
+}
+
+static inline int32_t qoi_clamp_diff(int32_t value, int32_t low, int32_t high)
+{
+    return (value < low) ? low : (value > high) ? high : value;
+}
+
+/*
+    Picks the pixel the encoder should store in place of cur_pixel: the cheapest
+    pixel within bound of it that a run, index, diff or luma chunk can reproduce
+    exactly. Falls back to cur_pixel itself when none is close enough.
+*/
+static qoi_pixel_t qoi_quantize_pixel(qoi_desc_t* desc, qoi_enc_t* enc, qoi_pixel_t cur_pixel, const uint8_t bound[4])
+{
+    qoi_pixel_t prev = enc->prev_pixel;
+    qoi_pixel_t candidate;
+    int32_t green_diff;
+
+    if (desc->channels < 4)
+        cur_pixel.alpha = 255;
+    else if (qoi_within_bound(prev.alpha, cur_pixel.alpha, bound[QOI_ALPHA]))
+        cur_pixel.alpha = prev.alpha; /* Keeping alpha avoids a five byte RGBA chunk */
+
+    /* Anything else that changes alpha needs an exact RGBA chunk */
+    if (cur_pixel.alpha != prev.alpha)
+        return cur_pixel;
+
+    /* Run: repeat the previous pixel */
+    if (qoi_within_bound(prev.red, cur_pixel.red, bound[QOI_RED]) &&
+        qoi_within_bound(prev.green, cur_pixel.green, bound[QOI_GREEN]) &&
+        qoi_within_bound(prev.blue, cur_pixel.blue, bound[QOI_BLUE]))
+        return prev;
+
+    /* Diff: every channel within -2..1 of the previous pixel */
+    candidate = prev;
+    for (uint8_t channel = QOI_RED; channel <= QOI_BLUE; channel++)
+    {
+        int32_t value = prev.channels[channel] + qoi_clamp_diff(cur_pixel.channels[channel] - prev.channels[channel], -2, 1);
+
+        if (!qoi_within_bound(value, cur_pixel.channels[channel], bound[channel])) break;
+
+        candidate.channels[channel] = (uint8_t)value;
+
+        if (channel == QOI_BLUE) return candidate;
+    }
+
+    /* Index: a recently seen pixel that is close enough */
+    for (uint8_t element = 0; element < 64; element++)
+    {
+        qoi_pixel_t seen = enc->buffer[element];
+
+        if (seen.alpha == cur_pixel.alpha &&
+            qoi_within_bound(seen.red, cur_pixel.red, bound[QOI_RED]) &&
+            qoi_within_bound(seen.green, cur_pixel.green, bound[QOI_GREEN]) &&
+            qoi_within_bound(seen.blue, cur_pixel.blue, bound[QOI_BLUE]))
+            return seen;
+    }
+
+    /* Luma: try green differences within bound so red and blue fit -8..7 around them */
+    green_diff = cur_pixel.green - prev.green;
+
+    for (int32_t offset = 0; offset <= 2 * (int32_t)bound[QOI_GREEN]; offset++)
+    {
+        /* Search outwards from the exact green difference: 0, -1, +1, -2, +2 ... */
+        int32_t dg = qoi_clamp_diff(green_diff + ((offset & 1) ? -(offset + 1) / 2 : offset / 2), -32, 31);
+        int32_t red = prev.red + dg + qoi_clamp_diff(cur_pixel.red - prev.red - dg, -8, 7);
+        int32_t blue = prev.blue + dg + qoi_clamp_diff(cur_pixel.blue - prev.blue - dg, -8, 7);
+
+        if (qoi_within_bound(prev.green + dg, cur_pixel.green, bound[QOI_GREEN]) &&
+            qoi_within_bound(red, cur_pixel.red, bound[QOI_RED]) &&
+            qoi_within_bound(blue, cur_pixel.blue, bound[QOI_BLUE]))
+        {
+            candidate.red = (uint8_t)red;
+            candidate.green = (uint8_t)(prev.green + dg);
+            candidate.blue = (uint8_t)blue;
+
+            return candidate;
+        }
+    }
+
+    return cur_pixel;
+}
+
+/*
+    Near lossless encoding: every channel of the decoded pixel is within bound of
+    the source pixel, indexed by enum qoi_pixel_color. The encoder keeps the
+    reconstructed pixels as its previous pixel and index so errors never add up
+    and the output is a standard QOI file. A bound of all zeros is lossless.
+*/
+void qoi_encode_chunk_near_lossless(qoi_desc_t *desc, qoi_enc_t *enc, void *qoi_pixel_bytes, const uint8_t bound[4])
+{
+    qoi_pixel_t cur_pixel = *((qoi_pixel_t*)qoi_pixel_bytes);
+
+    qoi_encode_pixel(desc, enc, qoi_quantize_pixel(desc, enc, cur_pixel, bound));
+}
+
+/* Encodes one pixel already in qoi_pixel_t form, such as a pixel converted from another format */
+void qoi_encode_pixel(qoi_desc_t *desc, qoi_enc_t *enc, qoi_pixel_t cur_pixel)
+{
+    /* Assume an RGB pixel with three channels has an alpha value that makes pixels opaque */
+    if (desc->channels < 4) 
+        cur_pixel.alpha = 255;
+
+    uint8_t index_pos = qoi_get_index_position(cur_pixel);
+
+    /* Increment run length by 1 if pixels are the same */
+    if (qoi_cmp_pixel(cur_pixel, enc->prev_pixel, desc->channels))
+    {
+        /*  Note that the runlengths 63 and 64 (b111110 and b111111) are illegal as they are
+            occupied by the QOI_OP_RGB and QOI_OP_RGBA tags. */
+        if (++enc->run >= 62 || enc->pixel_offset + 1 >= enc->len) /* pixel_offset is advanced below, so the last pixel is len - 1 */
+        {
+            qoi_enc_run(enc);
+        }
+    }
+    else
+    {
+        if (enc->run > 0)
+        {
+            /*  Write opcode for because there are differences in pixels
+                The run-length is stored with a bias of -1 */
+            qoi_enc_run(enc);
+        }
+        
+        /* Check if pixels exist in one of the pixel hash buffers */
+        if (qoi_cmp_pixel(enc->buffer[index_pos], cur_pixel, 4))
+        {
+            qoi_enc_index(enc, index_pos);
+        }
+        else
+        {
+            enc->buffer[index_pos] = cur_pixel;
+
+            /* QOI doesn't have opcodes for alpha values so check alpha values between two pixels first */
+            if (desc->channels > 3 && cur_pixel.alpha != enc->prev_pixel.alpha)
+            {
+                qoi_enc_rgba(enc, cur_pixel);
+            }
+            else
+            {
+#ifdef QOI_USE_SWAR
+                /* Differences of all channels at once; alpha is equal here so its lane is ignored */
+                uint32_t diff = qoi_swar_sub(cur_pixel.concatenated_pixel_values, enc->prev_pixel.concatenated_pixel_values);
+                uint8_t green_diff = (uint8_t)(diff >> QOI_SWAR_GREEN);
+                uint32_t luma = qoi_swar_sub(diff, ((uint32_t)green_diff << QOI_SWAR_RED) | ((uint32_t)green_diff << QOI_SWAR_BLUE));
+
+                /* With a bias every lane in range is left with only its low bits set */
+                if ((qoi_swar_add(diff, QOI_SWAR_RGB(2)) & QOI_SWAR_RGB(0xFC)) == 0)
+                {
+                    qoi_enc_diff(enc, (uint8_t)(diff >> QOI_SWAR_RED), green_diff, (uint8_t)(diff >> QOI_SWAR_BLUE));
+                }
+                else if ((qoi_swar_add(luma, (8u << QOI_SWAR_RED) | (32u << QOI_SWAR_GREEN) | (8u << QOI_SWAR_BLUE)) &
+                    ((0xF0u << QOI_SWAR_RED) | (0xC0u << QOI_SWAR_GREEN) | (0xF0u << QOI_SWAR_BLUE))) == 0)
+                {
+                    qoi_enc_luma(enc, green_diff, (uint8_t)(luma >> QOI_SWAR_RED), (uint8_t)(luma >> QOI_SWAR_BLUE));
+                }
+                else
+                {
+                    qoi_enc_rgb(enc, cur_pixel);
+                }
+#else
+                /* Check the difference between color values to determine opcode */
+                int8_t red_diff, green_diff, blue_diff;
+                int8_t dr_dg, db_dg;
+
+                red_diff = cur_pixel.red - enc->prev_pixel.red;
+                green_diff = cur_pixel.green - enc->prev_pixel.green;
+                blue_diff = cur_pixel.blue - enc->prev_pixel.blue;
+                
+                dr_dg = red_diff - green_diff;
+                db_dg = blue_diff - green_diff;
+
+                if (
+                    red_diff >= -2 && red_diff <= 1 &&
+                    green_diff >= -2 && green_diff <= 1 &&
+                    blue_diff >= -2 && blue_diff <= 1
+                )
+                {
+                    qoi_enc_diff(enc, red_diff, green_diff, blue_diff);
+                }
+
+                else if (
+                    dr_dg >= -8 && dr_dg <= 7 &&
+                    green_diff >= -32 && green_diff <= 31 &&
+                    db_dg >= -8 && db_dg <= 7
+                )
+                {
+                    qoi_enc_luma(enc, green_diff, dr_dg, db_dg);
+                }
+
+                /* otherwise write an RGB tag containting the RGB values of a pixel */
+                else
+                {
+                    qoi_enc_rgb(enc, cur_pixel);
+                }
+#endif
+            }
+
+        }
+    }
+
+    /* Advance the pixel offset by one and sets the previous pixel to the current pixel */
+    enc->prev_pixel = cur_pixel;
+    enc->pixel_offset++;
+
+    /* Write QOI padding when finished encoding the image */
+    if (qoi_enc_done(enc))
+        qoi_enc_padding(enc);
+}
+
+/* Candidate chunks of qoi_encode_pixel_branchless */
+enum
+{
+    QOI_CANDIDATE_RGB,
+    QOI_CANDIDATE_RGBA,
+    QOI_CANDIDATE_LUMA,
+    QOI_CANDIDATE_DIFF,
+    QOI_CANDIDATE_INDEX
+};
+
+/*
+    Chunk to use for each outcome of the index, alpha, DIFF and LUMA tests, with
+    the index hit in the highest bit. An index hit wins over everything, then a
+    change in alpha, then DIFF before LUMA before RGB.
+*/
+static const uint8_t qoi_candidate_lut[16] = {
+    QOI_CANDIDATE_RGB, QOI_CANDIDATE_LUMA, QOI_CANDIDATE_DIFF, QOI_CANDIDATE_DIFF,
+    QOI_CANDIDATE_RGBA, QOI_CANDIDATE_RGBA, QOI_CANDIDATE_RGBA, QOI_CANDIDATE_RGBA,
+    QOI_CANDIDATE_INDEX, QOI_CANDIDATE_INDEX, QOI_CANDIDATE_INDEX, QOI_CANDIDATE_INDEX,
+    QOI_CANDIDATE_INDEX, QOI_CANDIDATE_INDEX, QOI_CANDIDATE_INDEX, QOI_CANDIDATE_INDEX
+};
+
+/*
+    Encodes one pixel like qoi_encode_pixel without branching on the pixel values
+    to pick a chunk, which keeps noisy images from mispredicting on every pixel.
+
+    Every candidate chunk is built as a word holding its bytes from the lowest byte
+    up and its length in the top byte. The index, alpha, DIFF and LUMA range checks
+    look up the one qoi_encode_pixel would pick in qoi_candidate_lut, then five
+    bytes are stored and offset moves on by the chosen length. The output is the
+    same byte for byte.
+
+    WARNING: the output buffer must hold the whole worst case of
+    14 + width * height * (channels + 1) + 8 bytes, padding included. Five bytes
+    are stored for every chunk, so for three channel images the last store
+    reaches one byte into the room kept for the padding.
+*/
+void qoi_encode_pixel_branchless(qoi_desc_t *desc, qoi_enc_t *enc, qoi_pixel_t cur_pixel)
+{
+    qoi_pixel_t prev = enc->prev_pixel;
+    uint8_t index_pos;
+    uint64_t chunk, diff_chunk, luma_chunk, candidates[5];
+    uint8_t red_diff, green_diff, blue_diff, dr_dg, db_dg;
+    uint8_t index_hit, alpha_change, diff_fits, luma_fits;
+
+    if (desc->channels < 4)
+        cur_pixel.alpha = 255;
+
+    /* Runs stay branches: they are long and predictable wherever they occur */
+    if (cur_pixel.concatenated_pixel_values == prev.concatenated_pixel_values)
+    {
+        if (++enc->run >= 62 || enc->pixel_offset + 1 >= enc->len)
+            qoi_enc_run(enc);
+    }
+    else
+    {
+        /* Byte stores may alias the encoder so it is only written back at the end */
+        uint8_t* offset = enc->offset;
+
+        /* A pending run is always stored and only kept when there was one */
+        offset[0] = QOI_OP_RUN | (uint8_t)(enc->run - 1);
+        offset += (enc->run != 0);
+        enc->run = 0;
+
+        index_pos = (uint8_t)qoi_get_index_position(cur_pixel);
+
+        red_diff = (uint8_t)(cur_pixel.red - prev.red);
+        green_diff = (uint8_t)(cur_pixel.green - prev.green);
+        blue_diff = (uint8_t)(cur_pixel.blue - prev.blue);
+
+        dr_dg = (uint8_t)(red_diff - green_diff);
+        db_dg = (uint8_t)(blue_diff - green_diff);
+
+        /* With a bias every difference in range becomes a small unsigned value */
+        index_hit = enc->buffer[index_pos].concatenated_pixel_values == cur_pixel.concatenated_pixel_values;
+        alpha_change = cur_pixel.alpha != prev.alpha;
+        diff_fits = ((uint8_t)(red_diff + 2) < 4) & ((uint8_t)(green_diff + 2) < 4) & ((uint8_t)(blue_diff + 2) < 4);
+        luma_fits = ((uint8_t)(green_diff + 32) < 64) & ((uint8_t)(dr_dg + 8) < 16) & ((uint8_t)(db_dg + 8) < 16);
+
+        diff_chunk = QOI_OP_DIFF | (uint8_t)(red_diff + 2) << 4 | (uint8_t)(green_diff + 2) << 2 | (uint8_t)(blue_diff + 2);
+        luma_chunk = (QOI_OP_LUMA | (uint8_t)(green_diff + 32)) | (uint64_t)((uint8_t)(dr_dg + 8) << 4 | (uint8_t)(db_dg + 8)) << 8;
+
+        candidates[QOI_CANDIDATE_RGB] = QOI_OP_RGB | (uint64_t)cur_pixel.red << 8 | (uint64_t)cur_pixel.green << 16 | (uint64_t)cur_pixel.blue << 24 | (uint64_t)4 << 56;
+        candidates[QOI_CANDIDATE_RGBA] = QOI_OP_RGBA | (uint64_t)cur_pixel.red << 8 | (uint64_t)cur_pixel.green << 16 | (uint64_t)cur_pixel.blue << 24 | (uint64_t)cur_pixel.alpha << 32 | (uint64_t)5 << 56;
+        candidates[QOI_CANDIDATE_LUMA] = (luma_chunk & 0xFFFF) | (uint64_t)2 << 56;
+        candidates[QOI_CANDIDATE_DIFF] = (diff_chunk & 0xFF) | (uint64_t)1 << 56;
+        candidates[QOI_CANDIDATE_INDEX] = (uint64_t)(QOI_OP_INDEX | index_pos) | (uint64_t)1 << 56;
+
+        chunk = candidates[qoi_candidate_lut[index_hit << 3 | alpha_change << 2 | diff_fits << 1 | luma_fits]];
+
+        /* Storing an index hit again leaves the same pixel in place */
+        enc->buffer[index_pos] = cur_pixel;
+
+        offset[0] = (uint8_t)chunk;
+        offset[1] = (uint8_t)(chunk >> 8);
+        offset[2] = (uint8_t)(chunk >> 16);
+        offset[3] = (uint8_t)(chunk >> 24);
+        offset[4] = (uint8_t)(chunk >> 32);
+
+        enc->offset = offset + (chunk >> 56);
+    }
+
+    enc->prev_pixel = cur_pixel;
+    enc->pixel_offset++;
+
+    if (qoi_enc_done(enc))
+        qoi_enc_padding(enc);
+}
+
+/* Loads the pixel like qoi_encode_chunk and encodes it with qoi_encode_pixel_branchless */
+void qoi_encode_chunk_branchless(qoi_desc_t *desc, qoi_enc_t *enc, void *qoi_pixel_bytes)
+{
+    qoi_encode_pixel_branchless(desc, enc, *((qoi_pixel_t*)qoi_pixel_bytes));
+}
+
+/*
+    Prepares a palette of count colors with desc->channels bytes each for
+    qoi_encode_indexed. Hash positions and the chunk between every pair of
+    colors are worked out here once instead of for every pixel.
+*/
+bool qoi_palette_init(qoi_palette_t* palette, qoi_desc_t* desc, const void* colors, uint16_t count)
+{
+    const uint8_t* bytes = (const uint8_t*)colors;
+
+    if (palette == NULL || desc == NULL || colors == NULL || count == 0 || count > 256) return false;
+
+    palette->count = count;
+
+    for (uint16_t color = 0; color < 256; color++)
+    {
+        qoi_pixel_t* px = &palette->colors[color];
+
+        px->concatenated_pixel_values = 0;
+
+        if (color < count)
+        {
+            px->red = bytes[0];
+            px->green = bytes[1];
+            px->blue = bytes[2];
+            px->alpha = (desc->channels < 4) ? 255 : bytes[3];
+
+            bytes += desc->channels;
+        }
+
+        palette->index_position[color] = (uint8_t)qoi_get_index_position(*px);
+    }
+
+    /* Same choice between DIFF, LUMA, RGB and RGBA as qoi_encode_pixel */
+    for (uint16_t prev = 0; prev < count; prev++)
+    {
+        for (uint16_t cur = 0; cur < count; cur++)
+        {
+            qoi_pixel_t prev_pixel = palette->colors[prev];
+            qoi_pixel_t cur_pixel = palette->colors[cur];
+            int8_t red_diff, green_diff, blue_diff;
+            int8_t dr_dg, db_dg;
+            uint16_t op = QOI_PALETTE_OP_RGB;
+
+            red_diff = cur_pixel.red - prev_pixel.red;
+            green_diff = cur_pixel.green - prev_pixel.green;
+            blue_diff = cur_pixel.blue - prev_pixel.blue;
+
+            dr_dg = red_diff - green_diff;
+            db_dg = blue_diff - green_diff;
+
+            if (desc->channels > 3 && cur_pixel.alpha != prev_pixel.alpha)
+            {
+                op = QOI_PALETTE_OP_RGBA;
+            }
+            else if (
+                red_diff >= -2 && red_diff <= 1 &&
+                green_diff >= -2 && green_diff <= 1 &&
+                blue_diff >= -2 && blue_diff <= 1
+            )
+            {
+                op = (uint16_t)((QOI_OP_DIFF | (uint8_t)(red_diff + 2) << 4 | (uint8_t)(green_diff + 2) << 2 | (uint8_t)(blue_diff + 2)) << 8);
+            }
+            else if (
+                dr_dg >= -8 && dr_dg <= 7 &&
+                green_diff >= -32 && green_diff <= 31 &&
+                db_dg >= -8 && db_dg <= 7
+            )
+            {
+                op = (uint16_t)(((QOI_OP_LUMA | (uint8_t)(green_diff + 32)) << 8) | ((uint8_t)(dr_dg + 8) << 4 | (uint8_t)(db_dg + 8)));
+            }
+
+            palette->ops[prev][cur] = op;
+        }
+    }
+
+    return true;
+}
+
+/*
+    Encodes count pixels given as indices into a palette prepared by qoi_palette_init,
+    such as one row or the whole image. The output is identical to expanding the
+    indices to pixels and passing them to qoi_encode_chunk.
+
+    WARNING: every index must be below palette->count
+*/
+void qoi_encode_indexed(qoi_desc_t* desc, qoi_enc_t* enc, const qoi_palette_t* palette, const uint8_t* indices, size_t count)
+{
+    uint8_t prev_index;
+
+    if (count == 0 || qoi_enc_done(enc)) return;
+
+    /* The previous pixel may not be a palette color yet, so the first pixel takes the general path */
+    qoi_encode_pixel(desc, enc, palette->colors[indices[0]]);
+    prev_index = indices[0];
+
+    for (size_t seek = 1; seek < count && !qoi_enc_done(enc); seek++)
+    {
+        uint8_t cur_index = indices[seek];
+        qoi_pixel_t cur_pixel = palette->colors[cur_index];
+
+        if (cur_pixel.concatenated_pixel_values == enc->prev_pixel.concatenated_pixel_values)
+        {
+            if (++enc->run >= 62 || enc->pixel_offset + 1 >= enc->len)
+                qoi_enc_run(enc);
+        }
+        else
+        {
+            uint8_t index_pos = palette->index_position[cur_index];
+
+            if (enc->run > 0)
+                qoi_enc_run(enc);
+
+            if (enc->buffer[index_pos].concatenated_pixel_values == cur_pixel.concatenated_pixel_values)
+            {
+                qoi_enc_index(enc, index_pos);
+            }
+            else
+            {
+                uint16_t op = palette->ops[prev_index][cur_index];
+                uint8_t tag = (uint8_t)(op >> 8);
+
+                enc->buffer[index_pos] = cur_pixel;
+
+                if (tag >= QOI_OP_LUMA) /* LUMA is two bytes */
+                {
+                    enc->offset[0] = tag;
+                    enc->offset[1] = (uint8_t)op;
+                    enc->offset += 2;
+                }
+                else if (tag >= QOI_OP_DIFF)
+                {
+                    enc->offset++[0] = tag;
+                }
+                else if (op == QOI_PALETTE_OP_RGBA)
+                {
+                    qoi_enc_rgba(enc, cur_pixel);
+                }
+                else
+                {
+                    qoi_enc_rgb(enc, cur_pixel);
+                }
+            }
+        }
+
+        enc->prev_pixel = cur_pixel;
+        enc->pixel_offset++;
+        prev_index = cur_index;
+
+        if (qoi_enc_done(enc))
+            qoi_enc_padding(enc);
+    }
+}
+
+/*
+    YUV to RGB factors in 16.16 fixed point by matrix and range, worked out from
+    Kr and Kb of each matrix. Limited range stretches luma by 255 / 219 and
+    chroma by 255 / 224.
+*/
+static const int32_t QOI_YUV_FACTORS[2][2][5] = {
+    { /* BT.601: Kr = 0.299, Kb = 0.114 */
+        {76309, 104597, 25675, 53279, 132201},
+        {65536, 91881, 22553, 46802, 116130}
+    },
+    { /* BT.709: Kr = 0.2126, Kb = 0.0722 */
+        {76309, 117489, 13975, 34925, 138438},
+        {65536, 103206, 12276, 30679, 121609}
+    }
+};
+
+/* Pixels converted from YUV at a time; small enough to stay in the L1 cache */
+#define QOI_YUV_BLOCK 64
+
+/* Sets the format and conversion of a YUV frame; the planes and strides are filled in afterwards */
+bool qoi_yuv_init(qoi_yuv_t* yuv, uint8_t format, uint8_t matrix, uint8_t range)
+{
+    if (yuv == NULL || format > QOI_YUV_YUYV || matrix > QOI_YUV_BT709 || range > QOI_YUV_FULL) return false;
+
+    for (uint8_t plane = 0; plane < 3; plane++)
+    {
+        yuv->planes[plane] = NULL;
+        yuv->strides[plane] = 0;
+    }
+
+    yuv->format = format;
+    yuv->luma_offset = (range == QOI_YUV_LIMITED) ? 16 : 0;
+
+    for (uint8_t factor = 0; factor < 5; factor++)
+        yuv->factors[factor] = QOI_YUV_FACTORS[matrix][range][factor];
+
+    return true;
+}
+
+/* Rounds a 16.16 fixed point channel and clamps it to 0 to 255 */
+static inline uint8_t qoi_yuv_clamp(int32_t value)
+{
+    value += 1 << 15;
+
+    return (value < 0) ? 0 : (value >= 256 << 16) ? 255 : (uint8_t)(value >> 16);
+}
+
+/* Converts count pixels of a row starting at column x */
+static void qoi_yuv_convert(const qoi_yuv_t* yuv, size_t row, uint32_t x, uint32_t count, qoi_pixel_t* out)
+{
+    const int32_t* factors = yuv->factors;
+    const uint8_t *luma, *u, *v;
+    size_t luma_step, chroma_step;
+
+    /* Where the samples of this row are and how far apart */
+    switch (yuv->format)
+    {
+        case QOI_YUV_NV12:
+            luma = yuv->planes[0] + row * yuv->strides[0];
+            u = yuv->planes[1] + (row >> 1) * yuv->strides[1];
+            v = u + 1;
+            luma_step = 1;
+            chroma_step = 2;
+            break;
+        case QOI_YUV_YUYV:
+            luma = yuv->planes[0] + row * yuv->strides[0];
+            u = luma + 1;
+            v = luma + 3;
+            luma_step = 2;
+            chroma_step = 4;
+            break;
+        default:
+            luma = yuv->planes[0] + row * yuv->strides[0];
+            u = yuv->planes[1] + (row >> 1) * yuv->strides[1];
+            v = yuv->planes[2] + (row >> 1) * yuv->strides[2];
+            luma_step = 1;
+            chroma_step = 1;
+            break;
+    }
+
+    for (uint32_t seek = 0; seek < count; seek++)
+    {
+        size_t column = x + seek;
+        int32_t scaled_luma = ((int32_t)luma[column * luma_step] - yuv->luma_offset) * factors[0];
+        int32_t cb = (int32_t)u[(column >> 1) * chroma_step] - 128;
+        int32_t cr = (int32_t)v[(column >> 1) * chroma_step] - 128;
+
+        out[seek].red = qoi_yuv_clamp(scaled_luma + factors[1] * cr);
+        out[seek].green = qoi_yuv_clamp(scaled_luma - factors[2] * cb - factors[3] * cr);
+        out[seek].blue = qoi_yuv_clamp(scaled_luma + factors[4] * cb);
+        out[seek].alpha = 255;
+    }
+}
+
+/*
+    Encodes a whole YUV frame, converting it to RGB inside the encode loop so
+    no RGB copy of the frame is ever made. A few dozen pixels are converted at
+    a time into a buffer on the stack and encoded from there. The header must
+    already be written and the encoder initialized like for qoi_encode_chunk.
+
+    Rows of odd width frames still hold a chroma sample for the last pixel.
+*/
+bool qoi_encode_yuv(qoi_desc_t* desc, qoi_enc_t* enc, const qoi_yuv_t* yuv)
+{
+    qoi_pixel_t block[QOI_YUV_BLOCK];
+
+    if (desc == NULL || enc == NULL || yuv == NULL || yuv->planes[0] == NULL) return false;
+    if (yuv->format != QOI_YUV_YUYV && (yuv->planes[1] == NULL || (yuv->format == QOI_YUV_I420 && yuv->planes[2] == NULL))) return false;
+
+    for (size_t row = 0; row < desc->height && !qoi_enc_done(enc); row++)
+    {
+        for (uint32_t x = 0; x < desc->width; x += QOI_YUV_BLOCK)
+        {
+            uint32_t count = (desc->width - x < QOI_YUV_BLOCK) ? desc->width - x : QOI_YUV_BLOCK;
+
+            qoi_yuv_convert(yuv, row, x, count, block);
+
+            for (uint32_t seek = 0; seek < count; seek++)
+                qoi_encode_pixel(desc, enc, block[seek]);
+        }
+    }
+
+    return qoi_enc_done(enc);
+}
+
+/* Gets how many mip levels an image has down to 1x1, capped at QOI_MIP_MAX_LEVELS */
+uint8_t qoi_mip_max_levels(qoi_desc_t* desc)
+{
+    uint32_t width, height;
+    uint8_t levels = 1;
+
+    if (desc == NULL || desc->width == 0 || desc->height == 0) return 0;
+
+    width = desc->width;
+    height = desc->height;
+
+    while ((width > 1 || height > 1) && levels < QOI_MIP_MAX_LEVELS)
+    {
+        width = width / 2 + (width & 1);
+        height = height / 2 + (height & 1);
+        levels++;
+    }
+
+    return levels;
+}
+
+/*
+    Prepares levels mip levels of an image, level 0 being the image itself.
+    A QOI file for every level and a row of box sums for every level but the
+    first are taken from the allocator and freed by qoi_mip_destroy, so the
+    allocator needs both malloc_fn and free_fn. The QOI files start with room
+    for one row and grow through the allocator as rows are pushed.
+*/
+bool qoi_mip_init(qoi_mip_t* mip, qoi_desc_t* desc, uint8_t levels, const qoi_allocator_t* allocator)
+{
+    if (mip == NULL || desc == NULL || allocator == NULL) return false;
+    if (allocator->malloc_fn == NULL || allocator->free_fn == NULL) return false;
+    if (desc->channels < 3 || desc->channels > 4 || levels == 0 || levels > qoi_mip_max_levels(desc)) return false;
+
+    mip->levels = levels;
+    mip->allocator = *allocator;
+
+    for (uint8_t level = 0; level < levels; level++)
+    {
+        mip->enc[level].data = NULL;
+        mip->accum[level] = NULL;
+    }
+
+    for (uint8_t level = 0; level < levels; level++)
+    {
+        qoi_desc_t* level_desc = &mip->desc[level];
+        uint8_t* qoi_file;
+        size_t size;
+
+        *level_desc = *desc;
+
+        if (level > 0)
+        {
+            qoi_set_dimensions(level_desc,
+                mip->desc[level - 1].width / 2 + (mip->desc[level - 1].width & 1),
+                mip->desc[level - 1].height / 2 + (mip->desc[level - 1].height & 1));
+        }
+
+        if ((uint64_t)level_desc->width * level_desc->height > (SIZE_MAX - 14 - 8) / (desc->channels + 1))
+        {
+            qoi_mip_destroy(mip);
+            return false;
+        }
+
+        size = 14 + (size_t)level_desc->width * (desc->channels + 1) + 8;
+        qoi_file = (uint8_t*)allocator->malloc_fn(size, allocator->user);
+
+        if (level > 0)
+            mip->accum[level] = (uint32_t*)allocator->malloc_fn((size_t)level_desc->width * 4 * sizeof(uint32_t), allocator->user);
+
+        if (qoi_file == NULL || (level > 0 && mip->accum[level] == NULL))
+        {
+            if (qoi_file != NULL) allocator->free_fn(qoi_file, allocator->user);
+
+            qoi_mip_destroy(mip);
+            return false;
+        }
+
+        write_qoi_header(level_desc, qoi_file);
+
+        if (!qoi_enc_init(level_desc, &mip->enc[level], qoi_file))
+        {
+            allocator->free_fn(qoi_file, allocator->user);
+
+            qoi_mip_destroy(mip);
+            return false;
+        }
+
+        for (size_t element = 0; level > 0 && element < (size_t)level_desc->width * 4; element++)
+            mip->accum[level][element] = 0;
+
+        mip->rows[level] = 0;
+        mip->capacity[level] = size;
+    }
+
+    return true;
+}
+
+/* Encodes a pixel of a level and adds it to its box in the level below */
+static inline void qoi_mip_add_pixel(qoi_mip_t* mip, uint8_t level, uint32_t x, qoi_pixel_t px)
+{
+    qoi_encode_pixel(&mip->desc[level], &mip->enc[level], px);
+
+    if (level + 1 < mip->levels)
+    {
+        uint32_t* box = &mip->accum[level + 1][(x >> 1) * 4];
+
+        box[QOI_RED] += px.red;
+        box[QOI_GREEN] += px.green;
+        box[QOI_BLUE] += px.blue;
+        box[QOI_ALPHA] += px.alpha;
+    }
+}
+
+/*
+    Encodes the next row of the image with desc->channels bytes a pixel, and
+    every row of a smaller level whose boxes it completes. Each source row is
+    read once. Returns false once every row has been given, or if a QOI file
+    could not grow, in which case the row can be pushed again.
+*/
+bool qoi_mip_push_row(qoi_mip_t* mip, const void* row)
+{
+    const uint8_t* bytes = (const uint8_t*)row;
+    uint8_t channels;
+
+    if (mip == NULL || row == NULL || mip->rows[0] >= mip->desc[0].height) return false;
+
+    channels = mip->desc[0].channels;
+
+    /* Room for a row and the padding on every level before any of them is encoded */
+    for (uint8_t level = 0; level < mip->levels; level++)
+    {
+        if (!qoi_enc_reserve(&mip->allocator, &mip->enc[level], &mip->capacity[level], (size_t)mip->desc[level].width * (channels + 1) + 8))
+            return false;
+    }
+
+    for (uint32_t x = 0; x < mip->desc[0].width; x++)
+    {
+        qoi_mip_add_pixel(mip, 0, x, qoi_load_pixel(bytes, channels));
+        bytes += channels;
+    }
+
+    mip->rows[0]++;
+
+    /* A level gets a row after two rows of the level above or after its last one */
+    for (uint8_t level = 1; level < mip->levels; level++)
+    {
+        const qoi_desc_t* above = &mip->desc[level - 1];
+        uint32_t box_rows = mip->rows[level - 1] - mip->rows[level] * 2;
+        uint32_t* box = mip->accum[level];
+
+        if (mip->rows[level] >= mip->desc[level].height || (box_rows < 2 && mip->rows[level - 1] < above->height))
+            break;
+
+        for (uint32_t x = 0; x < mip->desc[level].width; x++, box += 4)
+        {
+            uint32_t count = ((above->width - x * 2 < 2) ? 1 : 2) * box_rows;
+            qoi_pixel_t px;
+
+            qoi_set_pixel_rgba(&px,
+                (uint8_t)((box[QOI_RED] + count / 2) / count),
+                (uint8_t)((box[QOI_GREEN] + count / 2) / count),
+                (uint8_t)((box[QOI_BLUE] + count / 2) / count),
+                (uint8_t)((box[QOI_ALPHA] + count / 2) / count));
+
+            box[QOI_RED] = box[QOI_GREEN] = box[QOI_BLUE] = box[QOI_ALPHA] = 0;
+
+            qoi_mip_add_pixel(mip, level, x, px);
+        }
+
+        mip->rows[level]++;
+    }
+
+    return true;
+}
+
+/*
+    Gets the QOI file of a level once it is complete, which is after the last
+    row of the image for every level. desc receives its header when not NULL.
+    The file belongs to mip until qoi_mip_destroy.
+*/
+const uint8_t* qoi_mip_level(const qoi_mip_t* mip, uint8_t level, qoi_desc_t* desc, size_t* len)
+{
+    if (mip == NULL || len == NULL || level >= mip->levels || mip->rows[level] < mip->desc[level].height) return NULL;
+
+    if (desc) *desc = mip->desc[level];
+
+    *len = (size_t)(mip->enc[level].offset - mip->enc[level].data);
+
+    return mip->enc[level].data;
+}
+
+/* Frees every QOI file and row of box sums of the mip levels */
+void qoi_mip_destroy(qoi_mip_t* mip)
+{
+    if (mip == NULL || mip->allocator.free_fn == NULL) return;
+
+    for (uint8_t level = 0; level < mip->levels; level++)
+    {
+        if (mip->enc[level].data) mip->allocator.free_fn(mip->enc[level].data, mip->allocator.user);
+        if (mip->accum[level]) mip->allocator.free_fn(mip->accum[level], mip->allocator.user);
+
+        mip->enc[level].data = NULL;
+        mip->accum[level] = NULL;
+    }
+}
+
+/*
+    Prepares to encode frames of the size and channels of desc. Two QOI files
+    and the row states are taken from the allocator and freed by
+    qoi_delta_destroy, so the allocator needs both malloc_fn and free_fn. The
+    QOI files start with room for one row and grow through the allocator.
+*/
+bool qoi_delta_init(qoi_delta_t* delta, qoi_desc_t* desc, const qoi_allocator_t* allocator)
+{
+    if (delta == NULL || desc == NULL || allocator == NULL) return false;
+    if (allocator->malloc_fn == NULL || allocator->free_fn == NULL) return false;
+    if (desc->channels < 3 || desc->channels > 4 || desc->width == 0 || desc->height == 0) return false;
+
+    if ((uint64_t)desc->width * desc->height > (SIZE_MAX - 14 - 8) / (desc->channels + 1)) return false;
+    if ((uint64_t)desc->height + 1 > SIZE_MAX / sizeof(qoi_row_state_t)) return false;
+
+    delta->desc = *desc;
+    delta->capacity = 14 + (size_t)desc->width * (desc->channels + 1) + 8;
+    delta->spare_capacity = delta->capacity;
+    delta->len = 0;
+    delta->encoded = false;
+    delta->allocator = *allocator;
+
+    delta->rows = (qoi_row_state_t*)allocator->malloc_fn(((size_t)desc->height + 1) * sizeof(qoi_row_state_t), allocator->user);
+    delta->qoi_file = (uint8_t*)allocator->malloc_fn(delta->capacity, allocator->user);
+    delta->spare = (uint8_t*)allocator->malloc_fn(delta->spare_capacity, allocator->user);
+
+    if (delta->rows == NULL || delta->qoi_file == NULL || delta->spare == NULL)
+    {
+        qoi_delta_destroy(delta);
+        return false;
+    }
+
+    return true;
+}
+
+/* Records the encoder state at the start of a row */
+static inline void qoi_delta_save(const qoi_enc_t* enc, qoi_row_state_t* state)
+{
+    for (uint8_t element = 0; element < 64; element++)
+        state->buffer[element] = enc->buffer[element];
+
+    state->prev_pixel = enc->prev_pixel;
+    state->run = enc->run;
+    state->offset = (size_t)(enc->offset - enc->data);
+}
+
+/* Puts the encoder back into the state recorded at the start of a row */
+static inline void qoi_delta_restore(qoi_enc_t* enc, const qoi_row_state_t* state)
+{
+    for (uint8_t element = 0; element < 64; element++)
+        enc->buffer[element] = state->buffer[element];
+
+    enc->prev_pixel = state->prev_pixel;
+    enc->run = state->run;
+}
+
+/* Makes room for size more bytes in the frame being encoded, which may move it */
+static inline bool qoi_delta_reserve(qoi_delta_t* delta, qoi_enc_t* enc, size_t size)
+{
+    if (!qoi_enc_reserve(&delta->allocator, enc, &delta->spare_capacity, size)) return false;
+
+    delta->spare = enc->data;
+
+    return true;
+}
+
+/* Copies bytes of the last QOI file; the builtin becomes the C library's memcpy where there is one */
+static inline void qoi_delta_copy(uint8_t* dest, const uint8_t* src, size_t len)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_memcpy(dest, src, len);
+#else
+    for (size_t seek = 0; seek < len; seek++)
+        dest[seek] = src[seek];
+#endif
+}
+
+/* Which index slots differ from the ones recorded at the start of a row? */
+static inline uint64_t qoi_delta_stale_slots(const qoi_enc_t* enc, const qoi_row_state_t* state)
+{
+    uint64_t stale = 0;
+
+    for (uint8_t element = 0; element < 64; element++)
+    {
+        if (enc->buffer[element].concatenated_pixel_values != state->buffer[element].concatenated_pixel_values)
+            stale |= (uint64_t)1 << element;
+    }
+
+    return stale;
+}
+
+/* Compares two rows; the builtin becomes the C library's vectorized memcmp where there is one */
+static inline bool qoi_delta_rows_equal(const uint8_t* row1, const uint8_t* row2, size_t len)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_memcmp(row1, row2, len) == 0;
+#else
+    for (size_t seek = 0; seek < len; seek++)
+    {
+        if (row1[seek] != row2[seek]) return false;
+    }
+
+    return true;
+#endif
+}
+
+/*
+    Is a row of the frame different from the last one? With hints only the pixels
+    inside the rectangles crossing the row are compared, and rows outside every
+    hint are taken as unchanged.
+*/
+static bool qoi_delta_row_changed(const qoi_delta_t* delta, const uint8_t* prev_frame, const uint8_t* frame, const qoi_rect_t* dirty, size_t dirty_count, uint32_t row)
+{
+    size_t row_size = (size_t)delta->desc.width * delta->desc.channels;
+    uint8_t channels = delta->desc.channels;
+
+    if (dirty == NULL)
+        return prev_frame == NULL || !qoi_delta_rows_equal(prev_frame + row * row_size, frame + row * row_size, row_size);
+
+    for (size_t rect = 0; rect < dirty_count; rect++)
+    {
+        uint32_t x = dirty[rect].x, width;
+
+        if (!(row >= dirty[rect].y && row - dirty[rect].y < dirty[rect].height) || x >= delta->desc.width) continue;
+
+        /* Columns past the right edge are left out */
+        width = (dirty[rect].width < delta->desc.width - x) ? dirty[rect].width : delta->desc.width - x;
+
+        if (width == 0) continue;
+        if (prev_frame == NULL) return true;
+
+        if (!qoi_delta_rows_equal(prev_frame + row * row_size + (size_t)x * channels, frame + row * row_size + (size_t)x * channels, (size_t)width * channels))
+            return true;
+    }
+
+    return false;
+}
+
+/*
+    Encodes a frame as a standard QOI file, reusing the last one where rows did
+    not change. prev_frame is the frame given to the previous call, or NULL to
+    rely on the dirty rectangles alone; dirty lists the rectangles that changed,
+    or is NULL to compare every row. With both, only the pixels inside the
+    rectangles are compared. Without either, or on the first frame, the whole
+    frame is encoded.
+
+    Rows before the first changed row are copied. After a changed row the
+    index slots it left different from the last frame are tracked, and the
+    old bytes of the unchanged rows that follow are copied up to the first
+    one that looks up such a slot, which is encoded again. The file decodes
+    to the frame but may pick other chunks than a full encode would.
+
+    Returns the QOI file, which stays valid until the next call, or NULL.
+*/
+const uint8_t* qoi_delta_encode(qoi_delta_t* delta, const void* prev_frame, const void* frame, const qoi_rect_t* dirty, size_t dirty_count, size_t* len)
+{
+    const uint8_t* prev_bytes = (const uint8_t*)prev_frame;
+    const uint8_t* frame_bytes = (const uint8_t*)frame;
+    qoi_desc_t* desc;
+    size_t row_size, capacity;
+    bool reuse;
+    uint8_t* swap;
+    qoi_enc_t enc;
+    uint64_t reads, writes;
+    uint32_t row = 0;
+
+    if (delta == NULL || delta->rows == NULL || frame == NULL || len == NULL) return NULL;
+
+    desc = &delta->desc;
+    row_size = (size_t)desc->width * desc->channels;
+    reuse = delta->encoded && (prev_frame != NULL || dirty != NULL);
+
+    if (!qoi_enc_init(desc, &enc, delta->spare)) return NULL;
+
+    if (reuse)
+    {
+        /* Everything up to the first changed row stays as it was */
+        while (row < desc->height && !qoi_delta_row_changed(delta, prev_bytes, frame_bytes, dirty, dirty_count, row))
+            row++;
+
+        enc.offset = enc.data;
+
+        if (!qoi_delta_reserve(delta, &enc, delta->rows[row].offset)) return NULL;
+
+        qoi_delta_copy(enc.data, delta->qoi_file, delta->rows[row].offset);
+
+        if (row < desc->height)
+            qoi_delta_restore(&enc, &delta->rows[row]);
+
+        enc.offset = enc.data + delta->rows[row].offset;
+        enc.pixel_offset = (size_t)row * desc->width;
+    }
+    else
+    {
+        write_qoi_header(desc, delta->spare);
+    }
+
+    while (row < desc->height)
+    {
+        const uint8_t* pixel_seek;
+
+        if (reuse && enc.run == delta->rows[row].run &&
+            enc.prev_pixel.concatenated_pixel_values == delta->rows[row].prev_pixel.concatenated_pixel_values)
+        {
+            /*
+                The old bytes of an unchanged row decode the same from this state
+                as long as they never look up a stale slot before writing it
+            */
+            uint64_t stale = qoi_delta_stale_slots(&enc, &delta->rows[row]);
+            size_t start = delta->rows[row].offset, new_start = (size_t)(enc.offset - enc.data);
+            uint32_t next = row;
+
+            while (next < desc->height && (stale & delta->rows[next].reads) == 0 &&
+                !qoi_delta_row_changed(delta, prev_bytes, frame_bytes, dirty, dirty_count, next))
+            {
+                /* The recorded state becomes the one the row now starts from */
+                for (uint8_t element = 0; stale != 0 && element < 64; element++)
+                {
+                    if (stale >> element & 1)
+                        delta->rows[next].buffer[element] = enc.buffer[element];
+                }
+
+                stale &= ~delta->rows[next].writes;
+                delta->rows[next].offset = delta->rows[next].offset - start + new_start;
+                next++;
+            }
+
+            if (next > row)
+            {
+                /* The recorded states now point into this frame, so a failure has to encode the next one in full */
+                if (!qoi_delta_reserve(delta, &enc, delta->rows[next].offset - start))
+                {
+                    delta->encoded = false;
+                    return NULL;
+                }
+
+                qoi_delta_copy(enc.offset, delta->qoi_file + start, delta->rows[next].offset - start);
+
+                enc.offset += delta->rows[next].offset - start;
+                enc.pixel_offset = (size_t)next * desc->width;
+
+                if (next < desc->height)
+                {
+                    for (uint8_t element = 0; element < 64; element++)
+                    {
+                        if (!(stale >> element & 1))
+                            enc.buffer[element] = delta->rows[next].buffer[element];
+                    }
+
+                    enc.prev_pixel = delta->rows[next].prev_pixel;
+                    enc.run = delta->rows[next].run;
+                }
+
+                row = next;
+                continue;
+            }
+        }
+
+        /* Room for the row and the padding after the last one */
+        if (!qoi_delta_reserve(delta, &enc, (size_t)desc->width * (desc->channels + 1) + 8))
+        {
+            delta->encoded = false;
+            return NULL;
+        }
+
+        qoi_delta_save(&enc, &delta->rows[row]);
+
+        pixel_seek = frame_bytes + row * row_size;
+        reads = 0;
+        writes = 0;
+
+        for (uint32_t x = 0; x < desc->width; x++)
+        {
+            qoi_pixel_t px = qoi_load_pixel(pixel_seek, desc->channels);
+
+            /* Mirror the encoder: a new pixel is either found in its slot or written to it */
+            if (px.concatenated_pixel_values != enc.prev_pixel.concatenated_pixel_values)
+            {
+                uint8_t index_pos = qoi_get_index_position(px);
+
+                if (enc.buffer[index_pos].concatenated_pixel_values == px.concatenated_pixel_values)
+                    reads |= ((uint64_t)1 << index_pos) & ~writes;
+                else
+                    writes |= (uint64_t)1 << index_pos;
+            }
+
+            qoi_encode_pixel(desc, &enc, px);
+            pixel_seek += desc->channels;
+        }
+
+        delta->rows[row].reads = reads;
+        delta->rows[row].writes = writes;
+        row++;
+    }
+
+    delta->rows[desc->height].offset = (size_t)(enc.offset - enc.data);
+
+    swap = delta->qoi_file;
+    delta->qoi_file = delta->spare;
+    delta->spare = swap;
+
+    capacity = delta->capacity;
+    delta->capacity = delta->spare_capacity;
+    delta->spare_capacity = capacity;
+
+    delta->len = delta->rows[desc->height].offset;
+    delta->encoded = true;
+
+    *len = delta->len;
+
+    return delta->qoi_file;
+}
+
+/* Frees the QOI files and row states */
+void qoi_delta_destroy(qoi_delta_t* delta)
+{
+    if (delta == NULL || delta->allocator.free_fn == NULL) return;
+
+    if (delta->rows) delta->allocator.free_fn(delta->rows, delta->allocator.user);
+    if (delta->qoi_file) delta->allocator.free_fn(delta->qoi_file, delta->allocator.user);
+    if (delta->spare) delta->allocator.free_fn(delta->spare, delta->allocator.user);
+
+    delta->rows = NULL;
+    delta->qoi_file = NULL;
+    delta->spare = NULL;
+    delta->encoded = false;
+}
+
+/* Get and set the RGB values from the QOI file */
+static inline void qoi_dec_rgb(qoi_dec_t* dec)
+{
+    dec->prev_pixel.red = dec->offset[1];
+    dec->prev_pixel.green = dec->offset[2];
+    dec->prev_pixel.blue = dec->offset[3];
+
+    dec->offset += 4;
+}
+
+/* Get and set the RGB values from the QOI file */
+static inline void qoi_dec_rgba(qoi_dec_t* dec)
+{
+    dec->prev_pixel.red = dec->offset[1];
+    dec->prev_pixel.green = dec->offset[2];
+    dec->prev_pixel.blue = dec->offset[3];
+    dec->prev_pixel.alpha = dec->offset[4];
+
+    dec->offset += 5;
+}
+
+/* Get and set the seek position of the buffer from the QOI file */
+static inline void qoi_dec_index(qoi_dec_t* dec, uint8_t tag)
+{
+    dec->prev_pixel = dec->buffer[tag & QOI_TAG_MASK];
+
+    dec->offset += 1;
+}
+
+/* Get the differences between values of the color channels from the QOI file */
+static inline void qoi_dec_diff(qoi_dec_t* dec, uint8_t tag)
+{
+    uint8_t diff = tag & QOI_TAG_MASK;
+
+#ifdef QOI_USE_SWAR
+    /* Unpack the biased differences into their lanes and apply them in one add */
+    uint32_t delta = ((uint32_t)((diff >> 4) & 0x03) << QOI_SWAR_RED) |
+        ((uint32_t)((diff >> 2) & 0x03) << QOI_SWAR_GREEN) |
+        ((uint32_t)(diff & 0x03) << QOI_SWAR_BLUE);
+
+    dec->prev_pixel.concatenated_pixel_values = qoi_swar_add(
+        dec->prev_pixel.concatenated_pixel_values,
+        qoi_swar_sub(delta, QOI_SWAR_RGB(2))
+        );
+#else
+    /* Do some wizardary to get the differences between three color channel values */
+
+    uint8_t red_diff = ((diff >> 4) & 0x03) - 2;
+    uint8_t green_diff = ((diff >> 2) & 0x03) - 2;
+    uint8_t blue_diff = (diff & 0x03) - 2;
+
+    /* Add up the differences between three color channel values individually */
+
+    dec->prev_pixel.red += red_diff;
+    dec->prev_pixel.green += green_diff;
+    dec->prev_pixel.blue += blue_diff;
+#endif
+
+    dec->offset += 1;
+}
+
+/* Gets the luma values from the QOI file */
+static inline void qoi_dec_luma(qoi_dec_t* dec, uint8_t tag)
+{
+    uint8_t lumaGreen = (tag & QOI_TAG_MASK) - 32;
+
+#ifdef QOI_USE_SWAR
+    /* Green difference in every color lane plus the red and blue offsets from it */
+    uint32_t delta = qoi_swar_sub(
+        ((uint32_t)(dec->offset[1] >> 4) << QOI_SWAR_RED) | ((uint32_t)(dec->offset[1] & 0x0F) << QOI_SWAR_BLUE),
+        (8u << QOI_SWAR_RED) | (8u << QOI_SWAR_BLUE)
+        );
+
+    dec->prev_pixel.concatenated_pixel_values = qoi_swar_add(
+        dec->prev_pixel.concatenated_pixel_values,
+        qoi_swar_add(delta, QOI_SWAR_RGB(lumaGreen))
+        );
+#else
+    /* Do some lumaGreen wizardary to get and add the differences between three color channel values */
+
+    dec->prev_pixel.red += lumaGreen + ((dec->offset[1] & 0xF0) >> 4) - 8;
+    dec->prev_pixel.green += lumaGreen;
+    dec->prev_pixel.blue += lumaGreen + (dec->offset[1] & 0x0F) - 8;
+#endif
+
+    dec->offset += 2;
+}
+
+/* Gets the run length of the pixel from the QOI file */
+static inline void qoi_dec_run(qoi_dec_t* dec, uint8_t tag){
+    dec->run = tag & QOI_TAG_MASK;
+
+    dec->offset += 1;
+}
+
+/* 
+    WARNING: In this function below, you must provide enough memory to put the decoded images 
+    The safest amount of space to store decoded images is the equation below
+
+    (image width) * (image height) * (amount of channels in a pixel) = bytes required to store decoded image
+*/
+
+qoi_pixel_t qoi_decode_chunk(qoi_dec_t* dec)
+{
+
+    if (dec->run > 0)
+        dec->run--;
+
+    else
+    {
+        uint8_t tag = dec->offset[0]; /* opcode for qoi decompression */
+
+        /*  
+            The 8-bit tags have precedence over the 2-bit tags. 
+            A decoder must check for the presence of an 8-bit tag first. 
+        */
+
+        if (tag == QOI_OP_RGB) /* RGB pixel */
+        {
+            qoi_dec_rgb(dec);
+        }
+        else if (tag == QOI_OP_RGBA) /* RGBA pixel */
+        {
+            qoi_dec_rgba(dec);
+        }
+        else
+        {
+            uint8_t tag_type = (tag & QOI_TAG); /* opcode for qoi decompression */
+
+            switch(tag_type)
+            {
+                case QOI_OP_INDEX:
+                {
+                    qoi_dec_index(dec, tag);
+
+                    break;
+                }
+                case QOI_OP_DIFF:
+                {
+                    qoi_dec_diff(dec, tag);
+
+                    break;
+                }
+                case QOI_OP_LUMA:
+                {
+                    qoi_dec_luma(dec, tag);
+
+                    break;
+                }
+                case QOI_OP_RUN:
+                {
+                    qoi_dec_run(dec, tag);
+
+                    break;
+                }
+                default:
+                {
+                    dec->offset += 1; /* move on to the new packet if there is an invaild opcode */
+
+                    break;
+                }
+            }           
+        }
+
+        dec->buffer[qoi_get_index_position(dec->prev_pixel)] = dec->prev_pixel;           
+    }
+    
+    dec->pixel_seek++;
+    return dec->prev_pixel;
+}
+
+/*
+    Decodes the whole image into interleaved pixels with desc->channels channels
+
+    WARNING: out must hold (image width) * (image height) * (amount of channels in a pixel) bytes
+    Returns false if the stream ended before every pixel was decoded.
+*/
+bool qoi_decode_pixels(qoi_desc_t* desc, qoi_dec_t* dec, void* out)
+{
+    uint8_t* bytes = (uint8_t*)out;
+
+    if (desc == NULL || dec == NULL || out == NULL) return false;
+
+    while (!qoi_dec_done(dec))
+    {
+        qoi_pixel_t px = qoi_decode_chunk(dec);
+
+        bytes[0] = px.red;
+        bytes[1] = px.green;
+        bytes[2] = px.blue;
+
+        if (desc->channels > 3) bytes[3] = px.alpha;
+
+        bytes += desc->channels;
+    }
+
+    return dec->pixel_seek >= dec->img_area;
+}
+
+/*
+    Size of a buffer that can decode a QOI file of qoi_len bytes in place:
+    the raw image plus enough slack that decoded pixels never catch up with
+    unread chunks. Returns 0 for dimensions that do not fit in memory.
+
+    A chunk is at most five bytes and every pixel writes desc->channels bytes,
+    so with D = qoi_len - 22 bytes of chunks the writes can get at most
+    D * (1 - channels / 5) + 8 bytes ahead of the reads over the whole image.
+*/
+size_t qoi_inplace_size(qoi_desc_t* desc, size_t qoi_len)
+{
+    size_t raw_len, chunk_len, slack;
+
+    if (desc == NULL || desc->channels < 3 || desc->channels > 4 || qoi_len < 14 + 8) return 0;
+
+    if (desc->height > 0 && desc->width > SIZE_MAX / desc->height / desc->channels) return 0;
+
+    raw_len = (size_t)desc->width * (size_t)desc->height * (size_t)desc->channels;
+    chunk_len = qoi_len - 14 - 8;
+
+    /* Rounded up; dividing first keeps the multiply from overflowing */
+    slack = chunk_len / 5 * (5 - desc->channels) + (chunk_len % 5 * (5 - desc->channels) + 4) / 5 + 8;
+
+    if (raw_len > SIZE_MAX - slack) return 0;
+
+    /* Incompressible images need room for the whole file instead */
+    return (raw_len + slack > qoi_len) ? raw_len + slack : qoi_len;
+}
+
+/*
+    Decodes a QOI file stored at the end of buffer into pixels written from the
+    start of the same buffer, so the file and the image never need separate memory.
+
+    Read the header first to get buffer_len from qoi_inplace_size, then load the
+    qoi_len bytes of the file, ending with QOI_PADDING, into the last qoi_len bytes
+    of buffer. desc receives the header. Returns false if the buffer is too small,
+    the header is invalid or the stream ended before every pixel was decoded.
+*/
+bool qoi_decode_inplace(qoi_desc_t* desc, void* buffer, size_t buffer_len, size_t qoi_len)
+{
+    qoi_dec_t dec;
+    uint8_t* bytes = (uint8_t*)buffer;
+    uint8_t* data;
+    size_t required;
+
+    if (desc == NULL || buffer == NULL || qoi_len > buffer_len) return false;
+
+    data = bytes + (buffer_len - qoi_len);
+
+    if (!read_qoi_header(desc, data)) return false;
+
+    required = qoi_inplace_size(desc, qoi_len);
+
+    if (required == 0 || buffer_len < required) return false;
+
+    if (!qoi_dec_init(desc, &dec, data, qoi_len)) return false;
+
+    while (!qoi_dec_done(&dec))
+    {
+        qoi_pixel_t px = qoi_decode_chunk(&dec);
+
+        /* The pixel may only go where every chunk was already read */
+        if (bytes + desc->channels > dec.offset) return false;
+
+        bytes[0] = px.red;
+        bytes[1] = px.green;
+        bytes[2] = px.blue;
+
+        if (desc->channels > 3) bytes[3] = px.alpha;
+
+        bytes += desc->channels;
+    }
+
+    return dec.pixel_seek >= dec.img_area;
+}
+
+/*
+    Consumes the rest of the current run in one step after qoi_decode_chunk
+    returned its first pixel. Returns how many more times that pixel repeats.
+*/
+static inline size_t qoi_dec_take_run(qoi_dec_t* dec)
+{
+    size_t run = dec->run;
+
+    /* Never repeat past the end of the image */
+    if (run > dec->img_area - dec->pixel_seek)
+        run = dec->img_area - dec->pixel_seek;
+
+    dec->run = 0;
+    dec->pixel_seek += run;
+
+    return run;
+}
+
+/* Gets the log2 of a thumbnail scale factor: 1/2, 1/4 or 1/8 are supported */
+static inline uint8_t qoi_thumb_shift(uint8_t scale)
+{
+    switch (scale)
+    {
+        case 2: return 1;
+        case 4: return 2;
+        case 8: return 3;
+        default: return 0;
+    }
+}
+
+/* Gets the dimensions of an image downscaled by 2, 4 or 8 rounding partial boxes up */
+bool qoi_thumb_dimensions(qoi_desc_t* desc, uint8_t scale, uint32_t* width, uint32_t* height)
+{
+    uint8_t shift = qoi_thumb_shift(scale);
+
+    if (desc == NULL || shift == 0) return false;
+
+    if (width != NULL)
+        *width = (uint32_t)(((uint64_t)desc->width + scale - 1) >> shift);
+
+    if (height != NULL)
+        *height = (uint32_t)(((uint64_t)desc->height + scale - 1) >> shift);
+
+    return true;
+}
+
+/* Amount of uint32_t elements the row accumulator given to qoi_decode_thumbnail must hold */
+size_t qoi_thumb_accum_size(qoi_desc_t* desc, uint8_t scale)
+{
+    uint32_t width;
+
+    if (!qoi_thumb_dimensions(desc, scale, &width, NULL)) return 0;
+
+    return (size_t)width * 4;
+}
+
+/* Averages one row of accumulated boxes into the thumbnail and clears the accumulator */
+static void qoi_thumb_flush_row(qoi_desc_t* desc, uint8_t shift, uint32_t box_rows, uint32_t* accum, uint8_t* row)
+{
+    uint32_t out_width = (uint32_t)(((uint64_t)desc->width + ((uint32_t)1 << shift) - 1) >> shift);
+
+    for (uint32_t cell = 0; cell < out_width; cell++)
+    {
+        /* Boxes on the right edge may be narrower than the scale factor */
+        uint32_t box_cols = desc->width - (cell << shift);
+        uint32_t count;
+
+        if (box_cols > ((uint32_t)1 << shift))
+            box_cols = (uint32_t)1 << shift;
+
+        count = box_cols * box_rows;
+
+        for (uint8_t channel = 0; channel < desc->channels; channel++)
+        {
+            row[channel] = (uint8_t)((accum[channel] + count / 2) / count);
+            accum[channel] = 0;
+        }
+
+        accum[QOI_ALPHA] = 0;
+
+        accum += 4;
+        row += desc->channels;
+    }
+}
+
+/*
+    Decodes the whole image straight into a thumbnail downscaled by 2, 4 or 8
+    by box averaging so the full resolution image never exists in memory.
+    accum must hold qoi_thumb_accum_size() elements and out must hold
+    (thumbnail width) * (thumbnail height) * (amount of channels in a pixel) bytes.
+    Returns false if the stream ended before every pixel was decoded.
+*/
+bool qoi_decode_thumbnail(qoi_desc_t* desc, qoi_dec_t* dec, uint8_t scale, uint32_t* accum, void* out)
+{
+    uint8_t shift = qoi_thumb_shift(scale);
+    uint8_t* row = (uint8_t*)out;
+    uint32_t x = 0, y = 0, box_rows = 0;
+    size_t row_bytes;
+
+    if (desc == NULL || dec == NULL || accum == NULL || out == NULL || shift == 0) return false;
+
+    /* The accumulator and rows are sized for RGB or RGBA pixels only */
+    if (desc->channels < 3 || desc->channels > 4) return false;
+
+    row_bytes = qoi_thumb_accum_size(desc, scale) / 4 * desc->channels;
+
+    for (size_t element = 0; element < qoi_thumb_accum_size(desc, scale); element++)
+        accum[element] = 0;
+
+    while (!qoi_dec_done(dec))
+    {
+        qoi_pixel_t px = qoi_decode_chunk(dec);
+
+        /* A run is added to each box it covers once instead of pixel by pixel */
+        size_t count = 1 + qoi_dec_take_run(dec);
+
+        while (count > 0)
+        {
+            uint32_t span = desc->width - x;
+
+            if (span > count)
+                span = (uint32_t)count;
+
+            count -= span;
+
+            /* Add the span to every box it overlaps on this row */
+            while (span > 0)
+            {
+                uint32_t* box = &accum[(x >> shift) * 4];
+                uint32_t box_span = (((x >> shift) + 1) << shift) - x;
+
+                if (box_span > span)
+                    box_span = span;
+
+                box[QOI_RED] += px.red * box_span;
+                box[QOI_GREEN] += px.green * box_span;
+                box[QOI_BLUE] += px.blue * box_span;
+                box[QOI_ALPHA] += px.alpha * box_span;
+
+                x += box_span;
+                span -= box_span;
+            }
+
+            if (x >= desc->width)
+            {
+                x = 0;
+                y++;
+                box_rows++;
+
+                /* Write a thumbnail row when a band of rows is complete */
+                if (box_rows == ((uint32_t)1 << shift) || y >= desc->height)
+                {
+                    qoi_thumb_flush_row(desc, shift, box_rows, accum, row);
+                    row += row_bytes;
+                    box_rows = 0;
+                }
+            }
+        }
+    }
+
+    return dec->pixel_seek >= dec->img_area;
+}
+
+/*
+    Gathers a histogram of every channel, channel sums for the average color,
+    the box around visible pixels and whether the image is one solid color
+    without writing any pixels. A run is counted once with its length instead
+    of pixel by pixel. Returns false if the stream ended early.
+*/
+bool qoi_analyze(qoi_desc_t* desc, qoi_dec_t* dec, qoi_stats_t* stats)
+{
+    uint32_t x = 0, y = 0;
+
+    if (desc == NULL || dec == NULL || stats == NULL || desc->width == 0) return false;
+
+    for (uint16_t value = 0; value < 256; value++)
+    {
+        for (uint8_t channel = 0; channel < 4; channel++)
+            stats->histogram[channel][value] = 0;
+    }
+
+    for (uint8_t channel = 0; channel < 4; channel++)
+        stats->sums[channel] = 0;
+
+    stats->pixel_count = 0;
+    stats->alpha_left = stats->alpha_top = stats->alpha_right = stats->alpha_bottom = 0;
+    stats->visible = false;
+    stats->solid = true;
+    qoi_set_pixel_rgba(&stats->first_pixel, 0, 0, 0, 255);
+
+    while (!qoi_dec_done(dec))
+    {
+        qoi_pixel_t px = qoi_decode_chunk(dec);
+        size_t count = 1 + qoi_dec_take_run(dec);
+
+        if (desc->channels < 4)
+            px.alpha = 255;
+
+        if (stats->pixel_count == 0)
+            stats->first_pixel = px;
+        else if (px.concatenated_pixel_values != stats->first_pixel.concatenated_pixel_values)
+            stats->solid = false;
+
+        for (uint8_t channel = 0; channel < 4; channel++)
+        {
+            stats->histogram[channel][px.channels[channel]] += count;
+            stats->sums[channel] += (uint64_t)px.channels[channel] * count;
+        }
+
+        stats->pixel_count += count;
+
+        /* Transparent pixels only move the position */
+        if (px.alpha == 0)
+        {
+            size_t position = (size_t)x + count;
+
+            x = (uint32_t)(position % desc->width);
+            y += (uint32_t)(position / desc->width);
+            continue;
+        }
+
+        /* Grow the box by the part of the run on each row it covers */
+        while (count > 0)
+        {
+            uint32_t span = desc->width - x;
+
+            if (span > count)
+                span = (uint32_t)count;
+
+            if (!stats->visible)
+            {
+                stats->alpha_left = x;
+                stats->alpha_top = y;
+                stats->alpha_right = x + span;
+                stats->visible = true;
+            }
+
+            if (x < stats->alpha_left)
+                stats->alpha_left = x;
+
+            if (x + span > stats->alpha_right)
+                stats->alpha_right = x + span;
+
+            stats->alpha_bottom = y + 1;
+
+            count -= span;
+            x += span;
+
+            if (x >= desc->width)
+            {
+                x = 0;
+                y++;
+            }
+        }
+    }
+
+    return dec->pixel_seek >= dec->img_area;
+}
+
+/* Gets the average color of an analyzed image rounded to the nearest value */
+qoi_pixel_t qoi_stats_average(const qoi_stats_t* stats)
+{
+    qoi_pixel_t average;
+
+    qoi_set_pixel_rgba(&average, 0, 0, 0, 255);
+
+    if (stats == NULL || stats->pixel_count == 0) return average;
+
+    for (uint8_t channel = 0; channel < 4; channel++)
+        average.channels[channel] = (uint8_t)((stats->sums[channel] + stats->pixel_count / 2) / stats->pixel_count);
+
+    return average;
+}
+
+/* sRGB encoded values to linear light lookup tables (IEC 61966-2-1) */
+static const float QOI_SRGB_TO_LINEAR_F32[256] = {
+    0.0f, 0.000303526991f, 0.000607053982f, 0.000910580973f, 0.00121410796f, 0.00151763496f, 0.00182116195f, 0.00212468882f,
+    0.00242821593f, 0.0027317428f, 0.00303526991f, 0.00334653584f, 0.00367650739f, 0.00402471703f, 0.00439144205f, 0.00477695325f,
+    0.00518151652f, 0.00560539169f, 0.00604883302f, 0.00651209056f, 0.00699541019f, 0.00749903219f, 0.00802319311f, 0.00856812578f,
+    0.00913405884f, 0.00972121768f, 0.010329823f, 0.0109600937f, 0.0116122449f, 0.012286488f, 0.0129830325f, 0.0137020834f,
+    0.0144438436f, 0.0152085144f, 0.0159962941f, 0.0168073755f, 0.0176419541f, 0.01850022f, 0.0193823613f, 0.0202885624f,
+    0.0212190095f, 0.0221738853f, 0.0231533665f, 0.0241576321f, 0.0251868591f, 0.0262412224f, 0.0273208916f, 0.02842604f,
+    0.0295568351f, 0.0307134446f, 0.0318960324f, 0.0331047662f, 0.0343398079f, 0.0356013142f, 0.0368894488f, 0.0382043719f,
+    0.0395462364f, 0.0409151986f, 0.0423114114f, 0.043735031f, 0.045186203f, 0.0466650873f, 0.0481718257f, 0.0497065671f,
+    0.0512694567f, 0.0528606474f, 0.054480277f, 0.0561284907f, 0.0578054301f, 0.0595112368f, 0.0612460524f, 0.0630100146f,
+    0.064803265f, 0.0666259378f, 0.0684781671f, 0.0703600943f, 0.0722718537f, 0.0742135718f, 0.0761853829f, 0.078187421f,
+    0.0802198201f, 0.0822827071f, 0.0843762085f, 0.0865004584f, 0.0886555836f, 0.0908417106f, 0.0930589661f, 0.0953074694f,
+    0.097587347f, 0.0998987257f, 0.102241732f, 0.104616486f, 0.107023105f, 0.10946171f, 0.111932427f, 0.114435375f,
+    0.116970666f, 0.119538426f, 0.122138776f, 0.124771819f, 0.127437681f, 0.130136475f, 0.13286832f, 0.135633335f,
+    0.138431609f, 0.141263291f, 0.144128472f, 0.147027269f, 0.149959788f, 0.152926147f, 0.155926466f, 0.158960834f,
+    0.162029371f, 0.165132195f, 0.168269396f, 0.171441108f, 0.174647406f, 0.177888423f, 0.18116425f, 0.18447499f,
+    0.187820777f, 0.191201687f, 0.194617838f, 0.198069319f, 0.20155625f, 0.205078736f, 0.208636865f, 0.212230757f,
+    0.215860501f, 0.219526201f, 0.223227963f, 0.226965874f, 0.230740055f, 0.23455058f, 0.238397568f, 0.242281124f,
+    0.246201321f, 0.25015828f, 0.254152089f, 0.258182853f, 0.262250662f, 0.266355604f, 0.270497799f, 0.274677306f,
+    0.278894275f, 0.283148736f, 0.287440836f, 0.291770637f, 0.296138257f, 0.300543785f, 0.304987311f, 0.309468925f,
+    0.313988715f, 0.318546772f, 0.323143214f, 0.327778101f, 0.332451522f, 0.337163627f, 0.341914415f, 0.346704066f,
+    0.351532608f, 0.356400132f, 0.361306787f, 0.366252601f, 0.371237695f, 0.376262128f, 0.38132602f, 0.386429429f,
+    0.391572475f, 0.396755219f, 0.401977777f, 0.407240212f, 0.412542611f, 0.417885065f, 0.423267663f, 0.428690493f,
+    0.434153646f, 0.439657182f, 0.445201188f, 0.450785786f, 0.456411034f, 0.462076992f, 0.467783809f, 0.473531485f,
+    0.479320168f, 0.48514995f, 0.491020858f, 0.496932983f, 0.502886474f, 0.50888133f, 0.514917672f, 0.520995557f,
+    0.527115107f, 0.533276379f, 0.539479494f, 0.545724452f, 0.55201143f, 0.558340371f, 0.564711511f, 0.571124852f,
+    0.577580452f, 0.584078431f, 0.590618849f, 0.597201765f, 0.603827357f, 0.610495567f, 0.617206573f, 0.623960376f,
+    0.630757153f, 0.637596846f, 0.644479692f, 0.651405632f, 0.658374846f, 0.665387273f, 0.672443151f, 0.679542482f,
+    0.686685324f, 0.693871737f, 0.701101899f, 0.708375752f, 0.715693474f, 0.723055124f, 0.730460763f, 0.73791039f,
+    0.745404184f, 0.752942204f, 0.760524511f, 0.768151164f, 0.775822222f, 0.783537805f, 0.791297913f, 0.799102724f,
+    0.806952238f, 0.814846575f, 0.822785735f, 0.830769897f, 0.838799f, 0.846873224f, 0.854992628f, 0.863157213f,
+    0.871367097f, 0.8796224f, 0.887923121f, 0.896269381f, 0.904661179f, 0.913098633f, 0.921581864f, 0.930110872f,
+    0.938685715f, 0.947306514f, 0.955973327f, 0.964686275f, 0.973445296f, 0.982250571f, 0.991102099f, 1.0f
+};
+
+static const uint16_t QOI_SRGB_TO_LINEAR_F16[256] = {
+    0x0000, 0x0CF9, 0x10F9, 0x1376, 0x14F9, 0x1637, 0x1776, 0x185A,
+    0x18F9, 0x1998, 0x1A37, 0x1ADB, 0x1B88, 0x1C1F, 0x1C7F, 0x1CE4,
+    0x1D4E, 0x1DBD, 0x1E32, 0x1EAB, 0x1F2A, 0x1FAE, 0x201C, 0x2063,
+    0x20AD, 0x20FA, 0x214A, 0x219D, 0x21F2, 0x224A, 0x22A6, 0x2304,
+    0x2365, 0x23C9, 0x2418, 0x244D, 0x2484, 0x24BC, 0x24F6, 0x2532,
+    0x256F, 0x25AD, 0x25ED, 0x262F, 0x2673, 0x26B8, 0x26FF, 0x2747,
+    0x2791, 0x27DD, 0x2815, 0x283D, 0x2865, 0x288F, 0x28B9, 0x28E4,
+    0x2910, 0x293D, 0x296A, 0x2999, 0x29C9, 0x29F9, 0x2A2A, 0x2A5D,
+    0x2A90, 0x2AC4, 0x2AF9, 0x2B2F, 0x2B66, 0x2B9E, 0x2BD7, 0x2C08,
+    0x2C26, 0x2C44, 0x2C62, 0x2C81, 0x2CA0, 0x2CC0, 0x2CE0, 0x2D01,
+    0x2D22, 0x2D44, 0x2D66, 0x2D89, 0x2DAD, 0x2DD0, 0x2DF5, 0x2E1A,
+    0x2E3F, 0x2E65, 0x2E8B, 0x2EB2, 0x2ED9, 0x2F01, 0x2F2A, 0x2F53,
+    0x2F7C, 0x2FA7, 0x2FD1, 0x2FFC, 0x3014, 0x302A, 0x3040, 0x3057,
+    0x306E, 0x3085, 0x309D, 0x30B4, 0x30CC, 0x30E5, 0x30FD, 0x3116,
+    0x312F, 0x3149, 0x3162, 0x317C, 0x3197, 0x31B1, 0x31CC, 0x31E7,
+    0x3203, 0x321E, 0x323A, 0x3257, 0x3273, 0x3290, 0x32AD, 0x32CB,
+    0x32E8, 0x3306, 0x3325, 0x3343, 0x3362, 0x3381, 0x33A1, 0x33C1,
+    0x33E1, 0x3401, 0x3411, 0x3422, 0x3432, 0x3443, 0x3454, 0x3465,
+    0x3476, 0x3488, 0x3499, 0x34AB, 0x34BD, 0x34CF, 0x34E1, 0x34F4,
+    0x3506, 0x3519, 0x352C, 0x353F, 0x3552, 0x3565, 0x3578, 0x358C,
+    0x35A0, 0x35B4, 0x35C8, 0x35DC, 0x35F1, 0x3605, 0x361A, 0x362F,
+    0x3644, 0x3659, 0x366F, 0x3684, 0x369A, 0x36B0, 0x36C6, 0x36DC,
+    0x36F2, 0x3709, 0x3720, 0x3736, 0x374D, 0x3765, 0x377C, 0x3794,
+    0x37AB, 0x37C3, 0x37DB, 0x37F3, 0x3806, 0x3812, 0x381F, 0x382B,
+    0x3838, 0x3844, 0x3851, 0x385E, 0x386B, 0x3877, 0x3885, 0x3892,
+    0x389F, 0x38AC, 0x38BA, 0x38C7, 0x38D5, 0x38E2, 0x38F0, 0x38FE,
+    0x390C, 0x391A, 0x3928, 0x3936, 0x3944, 0x3953, 0x3961, 0x3970,
+    0x397E, 0x398D, 0x399C, 0x39AB, 0x39BA, 0x39C9, 0x39D8, 0x39E7,
+    0x39F7, 0x3A06, 0x3A16, 0x3A25, 0x3A35, 0x3A45, 0x3A55, 0x3A65,
+    0x3A75, 0x3A85, 0x3A95, 0x3AA5, 0x3AB6, 0x3AC6, 0x3AD7, 0x3AE8,
+    0x3AF9, 0x3B09, 0x3B1A, 0x3B2C, 0x3B3D, 0x3B4E, 0x3B5F, 0x3B71,
+    0x3B82, 0x3B94, 0x3BA6, 0x3BB8, 0x3BCA, 0x3BDC, 0x3BEE, 0x3C00
+};
+
+/* Linear 8-bit values scaled to [0, 1] as half floats */
+static const uint16_t QOI_UNORM8_TO_F16[256] = {
+    0x0000, 0x1C04, 0x2004, 0x2206, 0x2404, 0x2505, 0x2606, 0x2707,
+    0x2804, 0x2885, 0x2905, 0x2986, 0x2A06, 0x2A87, 0x2B07, 0x2B88,
+    0x2C04, 0x2C44, 0x2C85, 0x2CC5, 0x2D05, 0x2D45, 0x2D86, 0x2DC6,
+    0x2E06, 0x2E46, 0x2E87, 0x2EC7, 0x2F07, 0x2F47, 0x2F88, 0x2FC8,
+    0x3004, 0x3024, 0x3044, 0x3064, 0x3085, 0x30A5, 0x30C5, 0x30E5,
+    0x3105, 0x3125, 0x3145, 0x3165, 0x3186, 0x31A6, 0x31C6, 0x31E6,
+    0x3206, 0x3226, 0x3246, 0x3266, 0x3287, 0x32A7, 0x32C7, 0x32E7,
+    0x3307, 0x3327, 0x3347, 0x3367, 0x3388, 0x33A8, 0x33C8, 0x33E8,
+    0x3404, 0x3414, 0x3424, 0x3434, 0x3444, 0x3454, 0x3464, 0x3474,
+    0x3485, 0x3495, 0x34A5, 0x34B5, 0x34C5, 0x34D5, 0x34E5, 0x34F5,
+    0x3505, 0x3515, 0x3525, 0x3535, 0x3545, 0x3555, 0x3565, 0x3575,
+    0x3586, 0x3596, 0x35A6, 0x35B6, 0x35C6, 0x35D6, 0x35E6, 0x35F6,
+    0x3606, 0x3616, 0x3626, 0x3636, 0x3646, 0x3656, 0x3666, 0x3676,
+    0x3687, 0x3697, 0x36A7, 0x36B7, 0x36C7, 0x36D7, 0x36E7, 0x36F7,
+    0x3707, 0x3717, 0x3727, 0x3737, 0x3747, 0x3757, 0x3767, 0x3777,
+    0x3788, 0x3798, 0x37A8, 0x37B8, 0x37C8, 0x37D8, 0x37E8, 0x37F8,
+    0x3804, 0x380C, 0x3814, 0x381C, 0x3824, 0x382C, 0x3834, 0x383C,
+    0x3844, 0x384C, 0x3854, 0x385C, 0x3864, 0x386C, 0x3874, 0x387C,
+    0x3885, 0x388D, 0x3895, 0x389D, 0x38A5, 0x38AD, 0x38B5, 0x38BD,
+    0x38C5, 0x38CD, 0x38D5, 0x38DD, 0x38E5, 0x38ED, 0x38F5, 0x38FD,
+    0x3905, 0x390D, 0x3915, 0x391D, 0x3925, 0x392D, 0x3935, 0x393D,
+    0x3945, 0x394D, 0x3955, 0x395D, 0x3965, 0x396D, 0x3975, 0x397D,
+    0x3986, 0x398E, 0x3996, 0x399E, 0x39A6, 0x39AE, 0x39B6, 0x39BE,
+    0x39C6, 0x39CE, 0x39D6, 0x39DE, 0x39E6, 0x39EE, 0x39F6, 0x39FE,
+    0x3A06, 0x3A0E, 0x3A16, 0x3A1E, 0x3A26, 0x3A2E, 0x3A36, 0x3A3E,
+    0x3A46, 0x3A4E, 0x3A56, 0x3A5E, 0x3A66, 0x3A6E, 0x3A76, 0x3A7E,
+    0x3A87, 0x3A8F, 0x3A97, 0x3A9F, 0x3AA7, 0x3AAF, 0x3AB7, 0x3ABF,
+    0x3AC7, 0x3ACF, 0x3AD7, 0x3ADF, 0x3AE7, 0x3AEF, 0x3AF7, 0x3AFF,
+    0x3B07, 0x3B0F, 0x3B17, 0x3B1F, 0x3B27, 0x3B2F, 0x3B37, 0x3B3F,
+    0x3B47, 0x3B4F, 0x3B57, 0x3B5F, 0x3B67, 0x3B6F, 0x3B77, 0x3B7F,
+    0x3B88, 0x3B90, 0x3B98, 0x3BA0, 0x3BA8, 0x3BB0, 0x3BB8, 0x3BC0,
+    0x3BC8, 0x3BD0, 0x3BD8, 0x3BE0, 0x3BE8, 0x3BF0, 0x3BF8, 0x3C00
+};
+
+/*
+    Decodes the whole image into linear light RGBA floats, either float32
+    or IEEE half floats stored in uint16_t depending on format.
+    sRGB color channels go through a lookup table while linear images and
+    the alpha channel, which is always linear, are scaled to [0, 1].
+
+    WARNING: out must hold (image width) * (image height) * 4 floats or half floats
+    Returns false if the stream ended before every pixel was decoded.
+*/
+bool qoi_decode_float(qoi_desc_t* desc, qoi_dec_t* dec, uint8_t format, void* out)
+{
+    float* out_f32 = (float*)out;
+    uint16_t* out_f16 = (uint16_t*)out;
+
+    if (desc == NULL || dec == NULL || out == NULL) return false;
+    if (format != QOI_FLOAT32 && format != QOI_FLOAT16) return false;
+
+    while (!qoi_dec_done(dec))
+    {
+        qoi_pixel_t px = qoi_decode_chunk(dec);
+
+        /* Convert each pixel of a run once and replicate the result */
+        size_t count = 1 + qoi_dec_take_run(dec);
+
+        if (format == QOI_FLOAT32)
+        {
+            float value[4];
+
+            if (desc->colorspace == QOI_SRGB)
+            {
+                value[QOI_RED] = QOI_SRGB_TO_LINEAR_F32[px.red];
+                value[QOI_GREEN] = QOI_SRGB_TO_LINEAR_F32[px.green];
+                value[QOI_BLUE] = QOI_SRGB_TO_LINEAR_F32[px.blue];
+            }
+            else
+            {
+                value[QOI_RED] = px.red * (1.0f / 255.0f);
+                value[QOI_GREEN] = px.green * (1.0f / 255.0f);
+                value[QOI_BLUE] = px.blue * (1.0f / 255.0f);
+            }
+
+            value[QOI_ALPHA] = px.alpha * (1.0f / 255.0f);
+
+            for (; count > 0; count--)
+            {
+                out_f32[0] = value[QOI_RED];
+                out_f32[1] = value[QOI_GREEN];
+                out_f32[2] = value[QOI_BLUE];
+                out_f32[3] = value[QOI_ALPHA];
+
+                out_f32 += 4;
+            }
+        }
+        else
+        {
+            const uint16_t* color_table = (desc->colorspace == QOI_SRGB) ? QOI_SRGB_TO_LINEAR_F16 : QOI_UNORM8_TO_F16;
+            uint16_t value[4] = {
+                color_table[px.red],
+                color_table[px.green],
+                color_table[px.blue],
+                QOI_UNORM8_TO_F16[px.alpha]
+            };
+
+            for (; count > 0; count--)
+            {
+                out_f16[0] = value[QOI_RED];
+                out_f16[1] = value[QOI_GREEN];
+                out_f16[2] = value[QOI_BLUE];
+                out_f16[3] = value[QOI_ALPHA];
+
+                out_f16 += 4;
+            }
+        }
+    }
+
+    return dec->pixel_seek >= dec->img_area;
+}
+
+/*
+    Initalize a planar output format. Each channel goes to its own plane
+    plane_stride elements apart, usually (image width) * (image height).
+    Float planes hold values scaled to [0, 1] until qoi_planar_normalize is called.
+*/
+bool qoi_planar_init(qoi_planar_t* planar, uint8_t type, uint8_t channels, size_t plane_stride)
+{
+    if (planar == NULL || channels < 3 || channels > 4) return false;
+    if (type != QOI_PLANAR_U8 && type != QOI_PLANAR_F32) return false;
+
+    for (uint8_t channel = 0; channel < 4; channel++)
+    {
+        for (uint16_t value = 0; value < 256; value++)
+            planar->lut[channel][value] = value * (1.0f / 255.0f);
+    }
+
+    planar->plane_stride = plane_stride;
+    planar->type = type;
+    planar->channels = channels;
+
+    return true;
+}
+
+/* Folds per channel (value / 255 - mean) / std normalization into the float lookup table */
+void qoi_planar_normalize(qoi_planar_t* planar, const float mean[4], const float std[4])
+{
+    if (planar == NULL || mean == NULL || std == NULL) return;
+
+    for (uint8_t channel = 0; channel < 4; channel++)
+    {
+        float scale = (std[channel] != 0.0f) ? 1.0f / std[channel] : 1.0f;
+
+        for (uint16_t value = 0; value < 256; value++)
+            planar->lut[channel][value] = (value * (1.0f / 255.0f) - mean[channel]) * scale;
+    }
+}
+
+/*
+    Decodes the whole image with each channel written to its own plane
+    starting at dest, which may be a slot inside a larger batch tensor.
+
+    WARNING: dest must hold (planar channels) * plane_stride elements
+    Returns false if the stream ended before every pixel was decoded.
+*/
+bool qoi_decode_planar(qoi_desc_t* desc, qoi_dec_t* dec, const qoi_planar_t* planar, void* dest)
+{
+    size_t seek = 0;
+
+    if (desc == NULL || dec == NULL || planar == NULL || dest == NULL) return false;
+
+    /* A shorter stride would let each plane run into the next one and the last one past dest */
+    if (planar->plane_stride < (size_t)desc->width * (size_t)desc->height || dec->img_area > planar->plane_stride) return false;
+
+    while (!qoi_dec_done(dec))
+    {
+        qoi_pixel_t px = qoi_decode_chunk(dec);
+
+        /* Each plane gets a run filled in one go */
+        size_t count = 1 + qoi_dec_take_run(dec);
+
+        for (uint8_t channel = 0; channel < planar->channels; channel++)
+        {
+            uint8_t value = px.channels[channel];
+
+            if (planar->type == QOI_PLANAR_U8)
+            {
+                uint8_t* plane = (uint8_t*)dest + channel * planar->plane_stride + seek;
+
+                for (size_t element = 0; element < count; element++)
+                    plane[element] = value;
+            }
+            else
+            {
+                float* plane = (float*)dest + channel * planar->plane_stride + seek;
+                float normalized = planar->lut[channel][value];
+
+                for (size_t element = 0; element < count; element++)
+                    plane[element] = normalized;
+            }
+        }
+
+        seek += count;
+    }
+
+    return dec->pixel_seek >= dec->img_area;
+}
+
+/* Decodes one image of a batch into its slot of the tensor */
+static void qoi_decode_planar_job(void* arg, size_t index)
+{
+    qoi_planar_batch_t* batch = (qoi_planar_batch_t*)arg;
+    const qoi_planar_t* planar = batch->planar;
+    size_t element_size = (planar->type == QOI_PLANAR_U8) ? sizeof(uint8_t) : sizeof(float);
+    uint8_t* dest = (uint8_t*)batch->tensor + index * planar->channels * planar->plane_stride * element_size;
+    qoi_desc_t desc;
+    qoi_dec_t dec;
+    bool decoded = false;
+
+    qoi_desc_init(&desc);
+
+    /* Every image must fit the tensor's shape */
+    if (
+        batch->len[index] >= 14 + 8 &&
+        read_qoi_header(&desc, batch->data[index]) &&
+        desc.width == batch->width &&
+        desc.height == batch->height &&
+        qoi_dec_init(&desc, &dec, batch->data[index], batch->len[index])
+    )
+    {
+        decoded = qoi_decode_planar(&desc, &dec, planar, dest);
+    }
+
+    batch->status[index] = decoded;
+}
+
+/*
+    Decodes a batch of images into an NCHW tensor in a single call,
+    spread over parallel_for when one is given.
+    The status array of the batch tells which images failed to decode.
+    Returns false if any image failed to decode or the batch is invalid.
+*/
+bool qoi_decode_planar_batch(qoi_planar_batch_t* batch, qoi_parallel_for_t parallel_for, void* user)
+{
+    if (batch == NULL || batch->planar == NULL || batch->tensor == NULL) return false;
+    if (batch->data == NULL || batch->len == NULL || batch->status == NULL) return false;
+    if (batch->planar->plane_stride < (size_t)batch->width * (size_t)batch->height) return false;
+
+    if (parallel_for != NULL)
+    {
+        parallel_for(qoi_decode_planar_job, batch, batch->count, user);
+    }
+    else
+    {
+        for (size_t index = 0; index < batch->count; index++)
+            qoi_decode_planar_job(batch, index);
+    }
+
+    for (size_t index = 0; index < batch->count; index++)
+    {
+        if (!batch->status[index]) return false;
+    }
+
+    return true;
+}
+
+/* Read and write little endian integers of the archive format regardless of endianness */
+static inline uint32_t qoi_read_le32(const uint8_t* bytes)
+{
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+static inline uint64_t qoi_read_le64(const uint8_t* bytes)
+{
+    return (uint64_t)qoi_read_le32(bytes) | ((uint64_t)qoi_read_le32(bytes + 4) << 32);
+}
+
+static inline void qoi_write_le32(uint8_t* bytes, uint32_t value)
+{
+    bytes[0] = (uint8_t)value;
+    bytes[1] = (uint8_t)(value >> 8);
+    bytes[2] = (uint8_t)(value >> 16);
+    bytes[3] = (uint8_t)(value >> 24);
+}
+
+static inline void qoi_write_le64(uint8_t* bytes, uint64_t value)
+{
+    qoi_write_le32(bytes, (uint32_t)value);
+    qoi_write_le32(bytes + 4, (uint32_t)(value >> 32));
+}
+
+/* FNV-1a hash of an entry name used to sort and search the archive index */
+uint64_t qoi_archive_hash(const char* name, size_t name_len)
+{
+    uint64_t hash = 0xCBF29CE484222325ULL;
+
+    for (size_t seek = 0; seek < name_len; seek++)
+    {
+        hash ^= (uint8_t)name[seek];
+        hash *= 0x100000001B3ULL;
+    }
+
+    return hash;
+}
+
+/* Checks an archive already in memory, such as a memory mapped file */
+bool qoi_archive_open(qoi_archive_t* archive, const void* data, size_t len)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint64_t index_offset, names_offset;
+    uint32_t entry_count;
+
+    if (archive == NULL || data == NULL || len < QOI_ARCHIVE_HEADER_SIZE) return false;
+
+    if (!(bytes[0] == QOI_ARCHIVE_MAGIC[0] &&
+        bytes[1] == QOI_ARCHIVE_MAGIC[1] &&
+        bytes[2] == QOI_ARCHIVE_MAGIC[2] &&
+        bytes[3] == QOI_ARCHIVE_MAGIC[3])
+    ) return false;
+
+    if (qoi_read_le32(bytes + 4) != QOI_ARCHIVE_VERSION) return false;
+
+    entry_count = qoi_read_le32(bytes + 8);
+    index_offset = qoi_read_le64(bytes + 16);
+    names_offset = qoi_read_le64(bytes + 24);
+
+    /* The index and names must lie inside the archive */
+    if (index_offset > len || (uint64_t)entry_count * QOI_ARCHIVE_ENTRY_SIZE > len - index_offset) return false;
+    if (names_offset > len) return false;
+
+    archive->data = bytes;
+    archive->len = len;
+    archive->entry_count = entry_count;
+    archive->index = bytes + index_offset;
+    archive->names = (const char*)bytes + names_offset;
+
+    return true;
+}
+
+/* Gets an entry by its position in the index; entries whose QOI header disagrees with the index are rejected */
+bool qoi_archive_entry_at(const qoi_archive_t* archive, size_t index, qoi_archive_entry_t* entry)
+{
+    const uint8_t* record;
+    uint64_t data_offset, data_len, name_offset;
+    size_t names_left, name_len;
+    qoi_desc_t header;
+
+    if (archive == NULL || entry == NULL || index >= archive->entry_count) return false;
+
+    record = archive->index + index * QOI_ARCHIVE_ENTRY_SIZE;
+
+    data_offset = qoi_read_le64(record + 8);
+    data_len = qoi_read_le64(record + 16);
+    name_offset = qoi_read_le32(record + 24);
+    name_len = (size_t)record[28] | ((size_t)record[29] << 8);
+
+    /* Reject entries pointing outside of the archive */
+    names_left = archive->len - (size_t)((const uint8_t*)archive->names - archive->data);
+
+    if (data_offset > archive->len || data_len > archive->len - data_offset) return false;
+    if (name_offset > names_left || name_len > names_left - name_offset) return false;
+
+    entry->data = archive->data + data_offset;
+    entry->len = (size_t)data_len;
+    entry->name = archive->names + name_offset;
+    entry->name_len = name_len;
+
+    qoi_desc_init(&entry->desc);
+    qoi_set_channels(&entry->desc, record[30]);
+    qoi_set_colorspace(&entry->desc, record[31]);
+    qoi_set_dimensions(&entry->desc, qoi_read_le32(record + 32), qoi_read_le32(record + 36));
+
+    /* Outputs are sized from the index so the embedded QOI header has to agree with it */
+    qoi_desc_init(&header);
+
+    if (entry->len < 14 || !read_qoi_header(&header, (void*)entry->data)) return false;
+
+    if (
+        header.width != entry->desc.width ||
+        header.height != entry->desc.height ||
+        header.channels != entry->desc.channels
+    )
+        return false;
+
+    return true;
+}
+
+/* Compares the name of the entry at index with a name; negative, zero or positive like strcmp */
+static int qoi_archive_cmp_name(const qoi_archive_t* archive, size_t index, uint64_t hash, const char* name, size_t name_len)
+{
+    const uint8_t* record = archive->index + index * QOI_ARCHIVE_ENTRY_SIZE;
+    uint64_t entry_hash = qoi_read_le64(record);
+    qoi_archive_entry_t entry;
+    size_t shortest;
+
+    if (entry_hash != hash)
+        return (entry_hash < hash) ? -1 : 1;
+
+    if (!qoi_archive_entry_at(archive, index, &entry))
+        return -1;
+
+    shortest = (entry.name_len < name_len) ? entry.name_len : name_len;
+
+    for (size_t seek = 0; seek < shortest; seek++)
+    {
+        if ((uint8_t)entry.name[seek] != (uint8_t)name[seek])
+            return ((uint8_t)entry.name[seek] < (uint8_t)name[seek]) ? -1 : 1;
+    }
+
+    return (entry.name_len > name_len) - (entry.name_len < name_len);
+}
+
+/* Binary searches the index for a name; the entry points straight into the archive */
+bool qoi_archive_find(const qoi_archive_t* archive, const char* name, size_t name_len, qoi_archive_entry_t* entry)
+{
+    uint64_t hash;
+    size_t low = 0, high;
+
+    if (archive == NULL || name == NULL || entry == NULL) return false;
+
+    hash = qoi_archive_hash(name, name_len);
+    high = archive->entry_count;
+
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        int order = qoi_archive_cmp_name(archive, middle, hash, name, name_len);
+
+        if (order == 0)
+            return qoi_archive_entry_at(archive, middle, entry);
+
+        if (order < 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    return false;
+}
+
+typedef struct
+{
+    const qoi_archive_t* archive;
+    const size_t* indices;
+    void** outputs;
+    bool* status;
+} qoi_archive_batch_t;
+
+/* Decodes one archive entry of a batch */
+static void qoi_archive_decode_job(void* arg, size_t job)
+{
+    qoi_archive_batch_t* batch = (qoi_archive_batch_t*)arg;
+    qoi_archive_entry_t entry;
+    qoi_dec_t dec;
+    bool decoded = false;
+
+    /* The entry is only returned when its QOI header matches the index the output was sized from */
+    if (
+        qoi_archive_entry_at(batch->archive, batch->indices[job], &entry) &&
+        entry.len >= 14 + 8 &&
+        entry.desc.channels >= 3 && entry.desc.channels <= 4 &&
+        qoi_dec_init(&entry.desc, &dec, (void*)entry.data, entry.len)
+    )
+    {
+        decoded = qoi_decode_pixels(&entry.desc, &dec, batch->outputs[job]);
+    }
+
+    batch->status[job] = decoded;
+}
+
+/*
+    Decodes many archive entries, spread over parallel_for when one is given.
+    outputs[n] receives entry indices[n] with the channels stored in that entry
+    and must hold (width) * (height) * (channels) bytes.
+    Returns false if any entry failed to decode.
+*/
+bool qoi_archive_decode_batch(const qoi_archive_t* archive, const size_t* indices, void** outputs, bool* status, size_t count, qoi_parallel_for_t parallel_for, void* user)
+{
+    qoi_archive_batch_t batch;
+
+    if (archive == NULL || indices == NULL || outputs == NULL || status == NULL) return false;
+
+    batch.archive = archive;
+    batch.indices = indices;
+    batch.outputs = outputs;
+    batch.status = status;
+
+    if (parallel_for != NULL)
+    {
+        parallel_for(qoi_archive_decode_job, &batch, count, user);
+    }
+    else
+    {
+        for (size_t job = 0; job < count; job++)
+            qoi_archive_decode_job(&batch, job);
+    }
+
+    for (size_t job = 0; job < count; job++)
+    {
+        if (!status[job]) return false;
+    }
+
+    return true;
+}
+
+/* Writes the archive header to the start of an archive */
+void write_qoi_archive_header(void* dest, uint32_t entry_count, uint64_t index_offset, uint64_t names_offset)
+{
+    uint8_t* bytes = (uint8_t*)dest;
+
+    if (dest == NULL) return;
+
+    bytes[0] = QOI_ARCHIVE_MAGIC[0];
+    bytes[1] = QOI_ARCHIVE_MAGIC[1];
+    bytes[2] = QOI_ARCHIVE_MAGIC[2];
+    bytes[3] = QOI_ARCHIVE_MAGIC[3];
+
+    qoi_write_le32(bytes + 4, QOI_ARCHIVE_VERSION);
+    qoi_write_le32(bytes + 8, entry_count);
+    qoi_write_le32(bytes + 12, 0);
+    qoi_write_le64(bytes + 16, index_offset);
+    qoi_write_le64(bytes + 24, names_offset);
+}
+
+/*
+    Writes one QOI_ARCHIVE_ENTRY_SIZE byte index record.
+    Records must be written sorted by qoi_archive_hash of the name, then by name.
+*/
+void write_qoi_archive_entry(void* dest, const qoi_archive_entry_t* entry, uint64_t data_offset, uint32_t name_offset)
+{
+    uint8_t* bytes = (uint8_t*)dest;
+
+    if (dest == NULL || entry == NULL) return;
+
+    qoi_write_le64(bytes, qoi_archive_hash(entry->name, entry->name_len));
+    qoi_write_le64(bytes + 8, data_offset);
+    qoi_write_le64(bytes + 16, entry->len);
+    qoi_write_le32(bytes + 24, name_offset);
+
+    bytes[28] = (uint8_t)entry->name_len;
+    bytes[29] = (uint8_t)(entry->name_len >> 8);
+    bytes[30] = entry->desc.channels;
+    bytes[31] = entry->desc.colorspace;
+
+    qoi_write_le32(bytes + 32, entry->desc.width);
+    qoi_write_le32(bytes + 36, entry->desc.height);
+}
+
+/* Worst case size of one full size tile: a header, padding and channels + 1 bytes a pixel */
+static inline uint64_t qoi_tiled_slot_size(const qoi_desc_t* desc, uint32_t tile_width, uint32_t tile_height)
+{
+    uint64_t size = 14 + 8 + (uint64_t)tile_width * tile_height * (desc->channels + 1);
+
+    return (size + QOI_TILED_ALIGN - 1) / QOI_TILED_ALIGN * QOI_TILED_ALIGN;
+}
+
+/*
+    Worst case size of a tiled container: the header, the offset table and a
+    slot for every tile that holds a full size tile at its worst case size.
+    Returns 0 for unsupported or too large images.
+*/
+size_t qoi_tiled_max_size(qoi_desc_t* desc, uint32_t tile_width, uint32_t tile_height)
+{
+    uint64_t tiles_x, tiles_y, tile_count, slot, size;
+
+    if (desc == NULL || desc->channels < 3 || desc->channels > 4) return 0;
+    if (desc->width == 0 || desc->height == 0 || tile_width == 0 || tile_height == 0) return 0;
+
+    tiles_x = ((uint64_t)desc->width + tile_width - 1) / tile_width;
+    tiles_y = ((uint64_t)desc->height + tile_height - 1) / tile_height;
+    tile_count = tiles_x * tiles_y;
+
+    slot = qoi_tiled_slot_size(desc, tile_width, tile_height);
+    size = QOI_TILED_HEADER_SIZE + (tile_count + 1) * 8;
+
+    if (tile_count > (UINT64_MAX - size) / slot) return 0;
+
+    size += tile_count * slot;
+
+    if (size > SIZE_MAX) return 0;
+
+    return (size_t)size;
+}
+
+typedef struct
+{
+    qoi_desc_t* desc;
+    const uint8_t* pixels;
+    uint8_t* dest;
+    uint32_t tile_width, tile_height;
+    uint32_t tiles_x, tiles_y;
+} qoi_tiled_batch_t;
+
+/* Gets the size of a tile, which is clipped on the right and bottom edges of the image */
+static inline void qoi_tiled_tile_size(const qoi_desc_t* desc, uint32_t tile_width, uint32_t tile_height, uint32_t tile_x, uint32_t tile_y, uint32_t* width, uint32_t* height)
+{
+    uint32_t left = tile_x * tile_width, top = tile_y * tile_height;
+
+    *width = (desc->width - left < tile_width) ? desc->width - left : tile_width;
+    *height = (desc->height - top < tile_height) ? desc->height - top : tile_height;
+}
+
+/*
+    Encodes one tile into its slot, which follows the offset table in tile order.
+    The length of the tile is left in its entry of the offset table.
+*/
+static void qoi_tiled_encode_job(void* arg, size_t job)
+{
+    qoi_tiled_batch_t* batch = (qoi_tiled_batch_t*)arg;
+    uint8_t channels = batch->desc->channels;
+    uint32_t tile_x = (uint32_t)(job % batch->tiles_x);
+    uint32_t tile_y = (uint32_t)(job / batch->tiles_x);
+    size_t stride = (size_t)batch->desc->width * channels;
+    const uint8_t* row;
+    uint8_t* slot;
+    qoi_desc_t desc;
+    qoi_enc_t enc;
+    uint32_t width, height;
+
+    qoi_tiled_tile_size(batch->desc, batch->tile_width, batch->tile_height, tile_x, tile_y, &width, &height);
+
+    slot = batch->dest + QOI_TILED_HEADER_SIZE + ((size_t)batch->tiles_x * batch->tiles_y + 1) * 8;
+    slot += job * (size_t)qoi_tiled_slot_size(batch->desc, batch->tile_width, batch->tile_height);
+
+    qoi_desc_init(&desc);
+    qoi_set_dimensions(&desc, width, height);
+    qoi_set_channels(&desc, channels);
+    qoi_set_colorspace(&desc, batch->desc->colorspace);
+
+    write_qoi_header(&desc, slot);
+
+    /* A zero length marks the tile as failed; each job only writes its own entry */
+    if (!qoi_enc_init(&desc, &enc, slot))
+    {
+        qoi_write_le64(batch->dest + QOI_TILED_HEADER_SIZE + job * 8, 0);
+        return;
+    }
+
+    row = batch->pixels + (size_t)tile_y * batch->tile_height * stride + (size_t)tile_x * batch->tile_width * channels;
+
+    for (uint32_t y = 0; y < height; y++)
+    {
+        const uint8_t* pixel_seek = row;
+
+        for (uint32_t x = 0; x < width; x++)
+        {
+            qoi_encode_pixel(&desc, &enc, qoi_load_pixel(pixel_seek, channels));
+            pixel_seek += channels;
+        }
+
+        row += stride;
+    }
+
+    qoi_write_le64(batch->dest + QOI_TILED_HEADER_SIZE + job * 8, (uint64_t)(enc.offset - enc.data));
+}
+
+/*
+    Splits an image of interleaved pixels with desc->channels channels into tiles
+    and encodes them, spread over parallel_for when one is given. The tiles are
+    encoded into worst case slots of dest and then moved down next to each other.
+
+    WARNING: dest must hold qoi_tiled_max_size(desc, tile_width, tile_height) bytes
+    Returns the size of the container or 0 if the image is unsupported.
+*/
+size_t qoi_tiled_encode(qoi_desc_t* desc, const void* pixels, uint32_t tile_width, uint32_t tile_height, void* dest, qoi_parallel_for_t parallel_for, void* user)
+{
+    qoi_tiled_batch_t batch;
+    uint8_t* bytes = (uint8_t*)dest;
+    size_t tile_count, offset, slot, slot_size;
+
+    if (pixels == NULL || dest == NULL || qoi_tiled_max_size(desc, tile_width, tile_height) == 0) return 0;
+
+    batch.desc = desc;
+    batch.pixels = (const uint8_t*)pixels;
+    batch.dest = bytes;
+    batch.tile_width = tile_width;
+    batch.tile_height = tile_height;
+    batch.tiles_x = (uint32_t)(((uint64_t)desc->width + tile_width - 1) / tile_width);
+    batch.tiles_y = (uint32_t)(((uint64_t)desc->height + tile_height - 1) / tile_height);
+
+    tile_count = (size_t)batch.tiles_x * batch.tiles_y;
+
+    if (parallel_for != NULL)
+    {
+        parallel_for(qoi_tiled_encode_job, &batch, tile_count, user);
+    }
+    else
+    {
+        for (size_t job = 0; job < tile_count; job++)
+            qoi_tiled_encode_job(&batch, job);
+    }
+
+    /* Close the gaps between slots and turn the tile lengths into offsets */
+    offset = slot = QOI_TILED_HEADER_SIZE + (tile_count + 1) * 8;
+    slot_size = (size_t)qoi_tiled_slot_size(desc, tile_width, tile_height);
+
+    for (size_t tile = 0; tile < tile_count; tile++)
+    {
+        size_t len = (size_t)qoi_read_le64(bytes + QOI_TILED_HEADER_SIZE + tile * 8);
+
+        if (len == 0) return 0;
+
+        /* Tiles only ever move towards the start so copying forwards is safe */
+        for (size_t seek = 0; seek < len && offset != slot; seek++)
+            bytes[offset + seek] = bytes[slot + seek];
+
+        qoi_write_le64(bytes + QOI_TILED_HEADER_SIZE + tile * 8, offset);
+
+        /* The last tile ends the container without alignment */
+        offset += len;
+        slot += slot_size;
+
+        if (tile + 1 < tile_count)
+            offset = (offset + QOI_TILED_ALIGN - 1) / QOI_TILED_ALIGN * QOI_TILED_ALIGN;
+    }
+
+    qoi_write_le64(bytes + QOI_TILED_HEADER_SIZE + tile_count * 8, offset);
+
+    bytes[0] = QOI_TILED_MAGIC[0];
+    bytes[1] = QOI_TILED_MAGIC[1];
+    bytes[2] = QOI_TILED_MAGIC[2];
+    bytes[3] = QOI_TILED_MAGIC[3];
+
+    qoi_write_le32(bytes + 4, QOI_TILED_VERSION);
+    qoi_write_le32(bytes + 8, desc->width);
+    qoi_write_le32(bytes + 12, desc->height);
+    qoi_write_le32(bytes + 16, tile_width);
+    qoi_write_le32(bytes + 20, tile_height);
+
+    bytes[24] = desc->channels;
+    bytes[25] = desc->colorspace;
+    bytes[26] = 0;
+    bytes[27] = 0;
+
+    qoi_write_le32(bytes + 28, 0);
+
+    return offset;
+}
+
+/* Checks a tiled container already in memory, such as a memory mapped file */
+bool qoi_tiled_open(qoi_tiled_t* tiled, const void* data, size_t len)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint32_t tile_width, tile_height;
+    uint64_t tiles_x, tiles_y;
+
+    if (tiled == NULL || data == NULL || len < QOI_TILED_HEADER_SIZE) return false;
+
+    if (!(bytes[0] == QOI_TILED_MAGIC[0] &&
+        bytes[1] == QOI_TILED_MAGIC[1] &&
+        bytes[2] == QOI_TILED_MAGIC[2] &&
+        bytes[3] == QOI_TILED_MAGIC[3])
+    ) return false;
+
+    if (qoi_read_le32(bytes + 4) != QOI_TILED_VERSION) return false;
+
+    qoi_desc_init(&tiled->desc);
+    qoi_set_dimensions(&tiled->desc, qoi_read_le32(bytes + 8), qoi_read_le32(bytes + 12));
+    qoi_set_channels(&tiled->desc, bytes[24]);
+    qoi_set_colorspace(&tiled->desc, bytes[25]);
+
+    tile_width = qoi_read_le32(bytes + 16);
+    tile_height = qoi_read_le32(bytes + 20);
+
+    if (tiled->desc.width == 0 || tiled->desc.height == 0 || tile_width == 0 || tile_height == 0) return false;
+    if (tiled->desc.channels < 3 || tiled->desc.channels > 4) return false;
+
+    tiles_x = ((uint64_t)tiled->desc.width + tile_width - 1) / tile_width;
+    tiles_y = ((uint64_t)tiled->desc.height + tile_height - 1) / tile_height;
+
+    /* The offset table must lie inside the container */
+    if (tiles_x * tiles_y + 1 > (len - QOI_TILED_HEADER_SIZE) / 8) return false;
+
+    tiled->data = bytes;
+    tiled->len = len;
+    tiled->tile_width = tile_width;
+    tiled->tile_height = tile_height;
+    tiled->tiles_x = (uint32_t)tiles_x;
+    tiled->tiles_y = (uint32_t)tiles_y;
+    tiled->offsets = bytes + QOI_TILED_HEADER_SIZE;
+
+    return true;
+}
+
+/*
+    Gets the QOI file of one tile, pointing straight into the container.
+    desc receives its header, which must match the size the tile should have.
+*/
+bool qoi_tiled_tile(const qoi_tiled_t* tiled, uint32_t tile_x, uint32_t tile_y, qoi_desc_t* desc, const uint8_t** data, size_t* len)
+{
+    size_t tile;
+    uint64_t start, end;
+    uint32_t width, height;
+
+    if (tiled == NULL || desc == NULL || data == NULL || len == NULL) return false;
+    if (tile_x >= tiled->tiles_x || tile_y >= tiled->tiles_y) return false;
+
+    tile = (size_t)tile_y * tiled->tiles_x + tile_x;
+    start = qoi_read_le64(tiled->offsets + tile * 8);
+    end = qoi_read_le64(tiled->offsets + tile * 8 + 8);
+
+    /* Reject tiles pointing outside of the container */
+    if (start > end || end > tiled->len || end - start < 14 + 8) return false;
+
+    qoi_desc_init(desc);
+
+    if (!read_qoi_header(desc, (void*)(tiled->data + start))) return false;
+
+    qoi_tiled_tile_size(&tiled->desc, tiled->tile_width, tiled->tile_height, tile_x, tile_y, &width, &height);
+
+    if (desc->width != width || desc->height != height || desc->channels != tiled->desc.channels) return false;
+
+    *data = tiled->data + start;
+    *len = (size_t)(end - start);
+
+    return true;
+}
+
+typedef struct
+{
+    const qoi_tiled_t* tiled;
+    uint8_t* out;
+    uint32_t x, y, width, height; /* region of the image */
+    uint32_t first_x, first_y, tiles_x; /* tiles it touches */
+    bool* status; /* one entry per tile, each written only by its own job */
+} qoi_tiled_region_t;
+
+/* Decodes the part of one tile that lies inside the region */
+static bool qoi_tiled_decode_tile(const qoi_tiled_region_t* region, size_t job)
+{
+    const qoi_tiled_t* tiled = region->tiled;
+    uint32_t tile_x = region->first_x + (uint32_t)(job % region->tiles_x);
+    uint32_t tile_y = region->first_y + (uint32_t)(job / region->tiles_x);
+    uint32_t left = tile_x * tiled->tile_width, top = tile_y * tiled->tile_height;
+    uint32_t column_begin, column_end, row_begin, row_end;
+    uint32_t x = 0, y = 0;
+    uint8_t channels = tiled->desc.channels;
+    const uint8_t* data;
+    size_t len;
+    qoi_desc_t desc;
+    qoi_dec_t dec;
+
+    if (!qoi_tiled_tile(tiled, tile_x, tile_y, &desc, &data, &len) || !qoi_dec_init(&desc, &dec, (void*)data, len))
+        return false;
+
+    /* Columns and rows of the tile that are inside the region */
+    column_begin = (region->x > left) ? region->x - left : 0;
+    row_begin = (region->y > top) ? region->y - top : 0;
+    column_end = (region->x + region->width < left + desc.width) ? region->x + region->width - left : desc.width;
+    row_end = (region->y + region->height < top + desc.height) ? region->y + region->height - top : desc.height;
+
+    /* Rows below the region are never decoded */
+    while (y < row_end && !qoi_dec_done(&dec))
+    {
+        qoi_pixel_t px = qoi_decode_chunk(&dec);
+        size_t count = 1 + qoi_dec_take_run(&dec);
+
+        while (count > 0 && y < row_end)
+        {
+            uint32_t span = desc.width - x;
+
+            if (span > count)
+                span = (uint32_t)count;
+
+            if (y >= row_begin)
+            {
+                uint32_t from = (x > column_begin) ? x : column_begin;
+                uint32_t to = (x + span < column_end) ? x + span : column_end;
+                uint8_t* bytes = region->out + ((size_t)(top + y - region->y) * region->width + (left + from - region->x)) * channels;
+
+                for (; from < to; from++)
+                {
+                    bytes[0] = px.red;
+                    bytes[1] = px.green;
+                    bytes[2] = px.blue;
+
+                    if (channels > 3) bytes[3] = px.alpha;
+
+                    bytes += channels;
+                }
+            }
+
+            count -= span;
+            x += span;
+
+            if (x >= desc.width)
+            {
+                x = 0;
+                y++;
+            }
+        }
+    }
+
+    return y >= row_end;
+}
+
+static void qoi_tiled_decode_job(void* arg, size_t job)
+{
+    qoi_tiled_region_t* region = (qoi_tiled_region_t*)arg;
+
+    region->status[job] = qoi_tiled_decode_tile(region, job);
+}
+
+/* Gets the number of tiles a region touches, or 0 if the region is outside of the image */
+size_t qoi_tiled_region_tiles(const qoi_tiled_t* tiled, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+    if (tiled == NULL || width == 0 || height == 0) return 0;
+    if (x >= tiled->desc.width || width > tiled->desc.width - x) return 0;
+    if (y >= tiled->desc.height || height > tiled->desc.height - y) return 0;
+
+    return (size_t)((x + width - 1) / tiled->tile_width - x / tiled->tile_width + 1) *
+        ((y + height - 1) / tiled->tile_height - y / tiled->tile_height + 1);
+}
+
+/*
+    Decodes a region of the image from only the tiles it touches, spread over
+    parallel_for when one is given. Pass the whole image as the region to
+    decode everything.
+
+    status gets whether each tile decoded, in row order of the tiles the
+    region touches. It is needed with parallel_for and may be NULL without.
+
+    WARNING: out must hold (width) * (height) * (tiled->desc.channels) bytes
+    WARNING: status must hold qoi_tiled_region_tiles(tiled, x, y, width, height) entries
+    Returns false if the region is outside of the image or a tile failed to decode.
+*/
+bool qoi_tiled_decode_region(const qoi_tiled_t* tiled, uint32_t x, uint32_t y, uint32_t width, uint32_t height, void* out, bool* status, qoi_parallel_for_t parallel_for, void* user)
+{
+    qoi_tiled_region_t region;
+    size_t tile_count;
+    bool decoded = true;
+
+    tile_count = qoi_tiled_region_tiles(tiled, x, y, width, height);
+
+    if (tile_count == 0 || out == NULL || (parallel_for != NULL && status == NULL)) return false;
+
+    region.tiled = tiled;
+    region.out = (uint8_t*)out;
+    region.x = x;
+    region.y = y;
+    region.width = width;
+    region.height = height;
+    region.first_x = x / tiled->tile_width;
+    region.first_y = y / tiled->tile_height;
+    region.tiles_x = (x + width - 1) / tiled->tile_width - region.first_x + 1;
+    region.status = status;
+
+    if (parallel_for != NULL)
+    {
+        parallel_for(qoi_tiled_decode_job, &region, tile_count, user);
+
+        for (size_t job = 0; job < tile_count; job++)
+            decoded = decoded && status[job];
+    }
+    else
+    {
+        for (size_t job = 0; job < tile_count; job++)
+        {
+            bool tile_decoded = qoi_tiled_decode_tile(&region, job);
+
+            if (status != NULL) status[job] = tile_decoded;
+
+            decoded = decoded && tile_decoded;
+        }
+    }
+
+    return decoded;
+}
+
+/* CRC32C (Castagnoli) lookup table for the reflected polynomial 0x82F63B78 */
+static const uint32_t QOI_CRC32C_TABLE[256] = {
+    0x00000000, 0xF26B8303, 0xE13B70F7, 0x1350F3F4, 0xC79A971F, 0x35F1141C,
+    0x26A1E7E8, 0xD4CA64EB, 0x8AD958CF, 0x78B2DBCC, 0x6BE22838, 0x9989AB3B,
+    0x4D43CFD0, 0xBF284CD3, 0xAC78BF27, 0x5E133C24, 0x105EC76F, 0xE235446C,
+    0xF165B798, 0x030E349B, 0xD7C45070, 0x25AFD373, 0x36FF2087, 0xC494A384,
+    0x9A879FA0, 0x68EC1CA3, 0x7BBCEF57, 0x89D76C54, 0x5D1D08BF, 0xAF768BBC,
+    0xBC267848, 0x4E4DFB4B, 0x20BD8EDE, 0xD2D60DDD, 0xC186FE29, 0x33ED7D2A,
+    0xE72719C1, 0x154C9AC2, 0x061C6936, 0xF477EA35, 0xAA64D611, 0x580F5512,
+    0x4B5FA6E6, 0xB93425E5, 0x6DFE410E, 0x9F95C20D, 0x8CC531F9, 0x7EAEB2FA,
+    0x30E349B1, 0xC288CAB2, 0xD1D83946, 0x23B3BA45, 0xF779DEAE, 0x05125DAD,
+    0x1642AE59, 0xE4292D5A, 0xBA3A117E, 0x4851927D, 0x5B016189, 0xA96AE28A,
+    0x7DA08661, 0x8FCB0562, 0x9C9BF696, 0x6EF07595, 0x417B1DBC, 0xB3109EBF,
+    0xA0406D4B, 0x522BEE48, 0x86E18AA3, 0x748A09A0, 0x67DAFA54, 0x95B17957,
+    0xCBA24573, 0x39C9C670, 0x2A993584, 0xD8F2B687, 0x0C38D26C, 0xFE53516F,
+    0xED03A29B, 0x1F682198, 0x5125DAD3, 0xA34E59D0, 0xB01EAA24, 0x42752927,
+    0x96BF4DCC, 0x64D4CECF, 0x77843D3B, 0x85EFBE38, 0xDBFC821C, 0x2997011F,
+    0x3AC7F2EB, 0xC8AC71E8, 0x1C661503, 0xEE0D9600, 0xFD5D65F4, 0x0F36E6F7,
+    0x61C69362, 0x93AD1061, 0x80FDE395, 0x72966096, 0xA65C047D, 0x5437877E,
+    0x4767748A, 0xB50CF789, 0xEB1FCBAD, 0x197448AE, 0x0A24BB5A, 0xF84F3859,
+    0x2C855CB2, 0xDEEEDFB1, 0xCDBE2C45, 0x3FD5AF46, 0x7198540D, 0x83F3D70E,
+    0x90A324FA, 0x62C8A7F9, 0xB602C312, 0x44694011, 0x5739B3E5, 0xA55230E6,
+    0xFB410CC2, 0x092A8FC1, 0x1A7A7C35, 0xE811FF36, 0x3CDB9BDD, 0xCEB018DE,
+    0xDDE0EB2A, 0x2F8B6829, 0x82F63B78, 0x709DB87B, 0x63CD4B8F, 0x91A6C88C,
+    0x456CAC67, 0xB7072F64, 0xA457DC90, 0x563C5F93, 0x082F63B7, 0xFA44E0B4,
+    0xE9141340, 0x1B7F9043, 0xCFB5F4A8, 0x3DDE77AB, 0x2E8E845F, 0xDCE5075C,
+    0x92A8FC17, 0x60C37F14, 0x73938CE0, 0x81F80FE3, 0x55326B08, 0xA759E80B,
+    0xB4091BFF, 0x466298FC, 0x1871A4D8, 0xEA1A27DB, 0xF94AD42F, 0x0B21572C,
+    0xDFEB33C7, 0x2D80B0C4, 0x3ED04330, 0xCCBBC033, 0xA24BB5A6, 0x502036A5,
+    0x4370C551, 0xB11B4652, 0x65D122B9, 0x97BAA1BA, 0x84EA524E, 0x7681D14D,
+    0x2892ED69, 0xDAF96E6A, 0xC9A99D9E, 0x3BC21E9D, 0xEF087A76, 0x1D63F975,
+    0x0E330A81, 0xFC588982, 0xB21572C9, 0x407EF1CA, 0x532E023E, 0xA145813D,
+    0x758FE5D6, 0x87E466D5, 0x94B49521, 0x66DF1622, 0x38CC2A06, 0xCAA7A905,
+    0xD9F75AF1, 0x2B9CD9F2, 0xFF56BD19, 0x0D3D3E1A, 0x1E6DCDEE, 0xEC064EED,
+    0xC38D26C4, 0x31E6A5C7, 0x22B65633, 0xD0DDD530, 0x0417B1DB, 0xF67C32D8,
+    0xE52CC12C, 0x1747422F, 0x49547E0B, 0xBB3FFD08, 0xA86F0EFC, 0x5A048DFF,
+    0x8ECEE914, 0x7CA56A17, 0x6FF599E3, 0x9D9E1AE0, 0xD3D3E1AB, 0x21B862A8,
+    0x32E8915C, 0xC083125F, 0x144976B4, 0xE622F5B7, 0xF5720643, 0x07198540,
+    0x590AB964, 0xAB613A67, 0xB831C993, 0x4A5A4A90, 0x9E902E7B, 0x6CFBAD78,
+    0x7FAB5E8C, 0x8DC0DD8F, 0xE330A81A, 0x115B2B19, 0x020BD8ED, 0xF0605BEE,
+    0x24AA3F05, 0xD6C1BC06, 0xC5914FF2, 0x37FACCF1, 0x69E9F0D5, 0x9B8273D6,
+    0x88D28022, 0x7AB90321, 0xAE7367CA, 0x5C18E4C9, 0x4F48173D, 0xBD23943E,
+    0xF36E6F75, 0x0105EC76, 0x12551F82, 0xE03E9C81, 0x34F4F86A, 0xC69F7B69,
+    0xD5CF889D, 0x27A40B9E, 0x79B737BA, 0x8BDCB4B9, 0x988C474D, 0x6AE7C44E,
+    0xBE2DA0A5, 0x4C4623A6, 0x5F16D052, 0xAD7D5351
+};
+
+/* Feeds bytes into a raw CRC32C state without the initial and final inversion */
+static inline uint32_t qoi_crc32c_update(uint32_t state, const uint8_t* bytes, size_t len)
+{
+#if defined(QOI_CRC32C_SSE42) && (defined(__x86_64__) || defined(_M_X64))
+    for (; len >= 8; bytes += 8, len -= 8)
+    {
+        uint64_t word = (uint64_t)qoi_read_le32(bytes) | ((uint64_t)qoi_read_le32(bytes + 4) << 32);
+        state = (uint32_t)_mm_crc32_u64(state, word);
+    }
+#endif
+
+#if defined(QOI_CRC32C_SSE42)
+    for (; len >= 4; bytes += 4, len -= 4)
+        state = _mm_crc32_u32(state, qoi_read_le32(bytes));
+
+    for (; len > 0; bytes++, len--)
+        state = _mm_crc32_u8(state, bytes[0]);
+#elif defined(QOI_CRC32C_ARM)
+    for (; len >= 4; bytes += 4, len -= 4)
+        state = __crc32cw(state, qoi_read_le32(bytes));
+
+    for (; len > 0; bytes++, len--)
+        state = __crc32cb(state, bytes[0]);
+#else
+    for (; len > 0; bytes++, len--)
+        state = QOI_CRC32C_TABLE[(state ^ bytes[0]) & 0xFF] ^ (state >> 8);
+#endif
+
+    return state;
+}
+
+/*
+    Continues a CRC32C checksum over more bytes. Start with a crc of 0;
+    the result of one call can be passed to the next to checksum data in pieces.
+*/
+uint32_t qoi_crc32c(uint32_t crc, const void* data, size_t len)
+{
+    return ~qoi_crc32c_update(~crc, (const uint8_t*)data, len);
+}
+
+/* Resets both checksums before encoding or decoding an image */
+void qoi_hash_init(qoi_hash_t* hash)
+{
+    hash->qoi_crc = 0;
+    hash->pixel_crc = 0;
+    hash->hashed = NULL;
+}
+
+/* QOI bytes are checksummed in blocks this large while they are still in cache */
+#define QOI_HASH_BLOCK 256
+
+/*
+    Catches qoi_crc up with the bytes written or read so far.
+    data is the start of the QOI file whose header is checksummed first.
+*/
+static inline void qoi_hash_qoi_bytes(qoi_hash_t* hash, const uint8_t* data, const uint8_t* end, bool flush)
+{
+    if (hash->hashed == NULL)
+        hash->hashed = data;
+
+    if (end > hash->hashed && (flush || (size_t)(end - hash->hashed) >= QOI_HASH_BLOCK))
+    {
+        hash->qoi_crc = qoi_crc32c(hash->qoi_crc, hash->hashed, (size_t)(end - hash->hashed));
+        hash->hashed = end;
+    }
+}
+
+/*
+    Encodes one pixel like qoi_encode_chunk while updating both checksums.
+    The QOI header must already be written to the encoder's data.
+*/
+void qoi_encode_chunk_hashed(qoi_desc_t* desc, qoi_enc_t* enc, qoi_hash_t* hash, void* qoi_pixel_bytes)
+{
+    hash->pixel_crc = qoi_crc32c(hash->pixel_crc, qoi_pixel_bytes, desc->channels);
+
+    qoi_encode_chunk(desc, enc, qoi_pixel_bytes);
+
+    /* The padding is written along with the last pixel so the file checksum ends with it */
+    qoi_hash_qoi_bytes(hash, enc->data, enc->offset, qoi_enc_done(enc));
+}
+
+/* Decodes one pixel like qoi_decode_chunk while updating both checksums */
+qoi_pixel_t qoi_decode_chunk_hashed(qoi_desc_t* desc, qoi_dec_t* dec, qoi_hash_t* hash)
+{
+    qoi_pixel_t px = qoi_decode_chunk(dec);
+    const uint8_t* end = dec->offset;
+    bool last = dec->pixel_seek >= dec->img_area;
+
+    /* Include the padding after the last pixel when the file has it */
+    if (last && (size_t)(end - dec->data) + 8 <= dec->qoi_len)
+        end += 8;
+
+    hash->pixel_crc = qoi_crc32c(hash->pixel_crc, px.channels, desc->channels);
+    qoi_hash_qoi_bytes(hash, dec->data, end, last);
+
+    return px;
+}
+
+/*
+    Decodes the whole image like qoi_decode_pixels while updating both checksums.
+    The decoded pixels are checksummed a block at a time right after being written.
+*/
+bool qoi_decode_pixels_hashed(qoi_desc_t* desc, qoi_dec_t* dec, qoi_hash_t* hash, void* out)
+{
+    uint8_t* bytes = (uint8_t*)out;
+    uint8_t* block = bytes;
+
+    if (desc == NULL || dec == NULL || hash == NULL || out == NULL) return false;
+
+    while (!qoi_dec_done(dec))
+    {
+        qoi_pixel_t px = qoi_decode_chunk(dec);
+
+        bytes[0] = px.red;
+        bytes[1] = px.green;
+        bytes[2] = px.blue;
+
+        if (desc->channels > 3) bytes[3] = px.alpha;
+
+        bytes += desc->channels;
+
+        if ((size_t)(bytes - block) >= QOI_HASH_BLOCK)
+        {
+            hash->pixel_crc = qoi_crc32c(hash->pixel_crc, block, (size_t)(bytes - block));
+            block = bytes;
+
+            qoi_hash_qoi_bytes(hash, dec->data, dec->offset, false);
+        }
+    }
+
+    hash->pixel_crc = qoi_crc32c(hash->pixel_crc, block, (size_t)(bytes - block));
+
+    if (dec->pixel_seek >= dec->img_area && (size_t)(dec->offset - dec->data) + 8 <= dec->qoi_len)
+        qoi_hash_qoi_bytes(hash, dec->data, dec->offset + 8, true);
+    else
+        qoi_hash_qoi_bytes(hash, dec->data, dec->offset, true);
+
+    return dec->pixel_seek >= dec->img_area;
+}
+
+/*
+    Writes the checksum trailer right after QOI_PADDING:
+    the magic "qcsc" then the QOI and pixel checksums in big endian.
+
+    WARNING: dest must have QOI_HASH_TRAILER_SIZE bytes available
+*/
+void write_qoi_hash_trailer(const qoi_hash_t* hash, void* dest)
+{
+    uint8_t* bytes = (uint8_t*)dest;
+    uint32_t qoi_crc = qoi_to_be32(hash->qoi_crc);
+    uint32_t pixel_crc = qoi_to_be32(hash->pixel_crc);
+
+    for (uint8_t element = 0; element < 4; element++)
+    {
+        bytes[element] = QOI_HASH_MAGIC[element];
+        bytes[4 + element] = ((uint8_t*)&qoi_crc)[element];
+        bytes[8 + element] = ((uint8_t*)&pixel_crc)[element];
+    }
+}
+
+/*
+    Reads the checksum trailer from the end of a whole QOI file of len bytes.
+    Returns false if the file does not end with QOI_PADDING followed by a trailer.
+*/
+bool read_qoi_hash_trailer(qoi_hash_t* hash, const void* data, size_t len)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    const uint8_t* trailer, *padding;
+
+    if (hash == NULL || data == NULL || len < 14 + 8 + QOI_HASH_TRAILER_SIZE) return false;
 
-void qoi_encode_chunk(qoi_desc_t *desc, qoi_enc_t *enc, void *qoi_pixel_bytes)
+    trailer = bytes + len - QOI_HASH_TRAILER_SIZE;
+    padding = trailer - 8;
+
+    for (uint8_t element = 0; element < 8; element++)
+    {
+        if (padding[element] != QOI_PADDING[element]) return false;
+    }
+
+    for (uint8_t element = 0; element < 4; element++)
+    {
+        if (trailer[element] != QOI_HASH_MAGIC[element]) return false;
+    }
+
+    hash->qoi_crc = (uint32_t)trailer[4] << 24 | (uint32_t)trailer[5] << 16 | (uint32_t)trailer[6] << 8 | trailer[7];
+    hash->pixel_crc = (uint32_t)trailer[8] << 24 | (uint32_t)trailer[9] << 16 | (uint32_t)trailer[10] << 8 | trailer[11];
+    hash->hashed = NULL;
+
+    return true;
+}
+
+/*
+    Saves everything needed to carry on encoding after a restart into
+    QOI_ENC_STATE_SIZE bytes. Keep it together with the first
+    (enc->offset - enc->data) bytes of the QOI file, which never change again;
+    a pending run is part of the state and not of the file yet.
+
+    qoi_enc_state {
+        char magic[4]; // magic bytes "qoie"
+        uint32_t version; // QOI_ENC_STATE_VERSION
+        uint32_t width;
+        uint32_t height;
+        uint8_t channels;
+        uint8_t colorspace;
+        uint8_t run;
+        uint8_t reserved; // 0
+        uint8_t prev_pixel[4]; // red, green, blue, alpha
+        uint64_t pixel_offset;
+        uint64_t byte_offset; // bytes of the QOI file written so far
+        uint8_t buffer[64][4];
+        uint32_t crc; // qoi_crc32c of everything above
+    };
+
+    All values are little endian.
+*/
+void write_qoi_enc_state(const qoi_desc_t* desc, const qoi_enc_t* enc, void* dest)
 {
+    uint8_t* bytes = (uint8_t*)dest;
 
-    /* 
-        Assume that the pixel byte order is the following below
-        bytes[0] = red;
-        bytes[1] = green;
-        bytes[2] = blue;
-        bytes[3] = alpha;
-    */
+    if (desc == NULL || enc == NULL || dest == NULL) return;
 
-    qoi_pixel_t cur_pixel = *((qoi_pixel_t*)qoi_pixel_bytes);
+    for (uint8_t element = 0; element < 4; element++)
+    {
+        bytes[element] = QOI_ENC_STATE_MAGIC[element];
+        bytes[20 + element] = enc->prev_pixel.channels[element];
+    }
 
-    /* Assume an RGB pixel with three channels has an alpha value that makes pixels opaque */
-    if (desc->channels < 4) 
-        cur_pixel.alpha = 255;
+    qoi_write_le32(bytes + 4, QOI_ENC_STATE_VERSION);
+    qoi_write_le32(bytes + 8, desc->width);
+    qoi_write_le32(bytes + 12, desc->height);
 
-    uint8_t index_pos = qoi_get_index_position(cur_pixel);
+    bytes[16] = desc->channels;
+    bytes[17] = desc->colorspace;
+    bytes[18] = enc->run;
+    bytes[19] = 0;
 
-    /* Increment run length by 1 if pixels are the same */
-    if (qoi_cmp_pixel(cur_pixel, enc->prev_pixel, desc->channels))
+    qoi_write_le64(bytes + 24, enc->pixel_offset);
+    qoi_write_le64(bytes + 32, (uint64_t)(enc->offset - enc->data));
+
+    for (uint8_t element = 0; element < 64; element++)
     {
-        /*  Note that the runlengths 63 and 64 (b111110 and b111111) are illegal as they are
-            occupied by the QOI_OP_RGB and QOI_OP_RGBA tags. */
-        if (++enc->run >= 62 || enc->pixel_offset >= enc->len)
-        {
-            qoi_enc_run(enc);
-        }
+        for (uint8_t channel = 0; channel < 4; channel++)
+            bytes[40 + element * 4 + channel] = enc->buffer[element].channels[channel];
     }
-    else
+
+    qoi_write_le32(bytes + QOI_ENC_STATE_SIZE - 4, qoi_crc32c(0, bytes, QOI_ENC_STATE_SIZE - 4));
+}
+
+/*
+    Restores a saved encoder state. data is the QOI file holding at least the
+    bytes written before the state was saved, with room for the rest of the
+    image after them; encoding carries on from where it stopped.
+    desc receives the image information of the state.
+    Returns false if the state is damaged or from another version.
+*/
+bool read_qoi_enc_state(qoi_desc_t* desc, qoi_enc_t* enc, const void* state, void* data)
+{
+    const uint8_t* bytes = (const uint8_t*)state;
+    uint64_t pixel_offset, byte_offset;
+
+    if (desc == NULL || enc == NULL || state == NULL || data == NULL) return false;
+
+    for (uint8_t element = 0; element < 4; element++)
     {
-        if (enc->run > 0)
-        {
-            /*  Write opcode for because there are differences in pixels
-                The run-length is stored with a bias of -1 */
-            qoi_enc_run(enc);
-        }
-        
-        /* Check if pixels exist in one of the pixel hash buffers */
-        if (qoi_cmp_pixel(enc->buffer[index_pos], cur_pixel, 4))
-        {
-            qoi_enc_index(enc, index_pos);
-        }
-        else
-        {
-            enc->buffer[index_pos] = cur_pixel;
+        if (bytes[element] != QOI_ENC_STATE_MAGIC[element]) return false;
+    }
 
-            /* QOI doesn't have opcodes for alpha values so check alpha values between two pixels first */
-            if (desc->channels > 3 && cur_pixel.alpha != enc->prev_pixel.alpha)
-            {
-                qoi_enc_rgba(enc, cur_pixel);
-            }
-            else
-            {
-                /* Check the difference between color values to determine opcode */
-                int8_t red_diff, green_diff, blue_diff;
-                int8_t dr_dg, db_dg;
+    if (qoi_read_le32(bytes + 4) != QOI_ENC_STATE_VERSION) return false;
+    if (qoi_read_le32(bytes + QOI_ENC_STATE_SIZE - 4) != qoi_crc32c(0, bytes, QOI_ENC_STATE_SIZE - 4)) return false;
 
-                red_diff = cur_pixel.red - enc->prev_pixel.red;
-                green_diff = cur_pixel.green - enc->prev_pixel.green;
-                blue_diff = cur_pixel.blue - enc->prev_pixel.blue;
-                
-                dr_dg = red_diff - green_diff;
-                db_dg = blue_diff - green_diff;
+    pixel_offset = qoi_read_le64(bytes + 24);
+    byte_offset = qoi_read_le64(bytes + 32);
 
-                if (
-                    red_diff >= -2 && red_diff <= 1 &&
-                    green_diff >= -2 && green_diff <= 1 &&
-                    blue_diff >= -2 && blue_diff <= 1
-                )
-                {
-                    qoi_enc_diff(enc, red_diff, green_diff, blue_diff);
-                }
+    if (bytes[16] < 3 || bytes[16] > 4 || bytes[18] >= 62 || byte_offset < 14 || byte_offset > SIZE_MAX) return false;
 
-                else if (
-                    dr_dg >= -8 && dr_dg <= 7 &&
-                    green_diff >= -32 && green_diff <= 31 &&
-                    db_dg >= -8 && db_dg <= 7
-                )
-                {
-                    qoi_enc_luma(enc, green_diff, dr_dg, db_dg);
-                }
+    qoi_desc_init(desc);
+    qoi_set_dimensions(desc, qoi_read_le32(bytes + 8), qoi_read_le32(bytes + 12));
+    qoi_set_channels(desc, bytes[16]);
+    qoi_set_colorspace(desc, bytes[17]);
 
-                /* otherwise write an RGB tag containting the RGB values of a pixel */
-                else
-                {
-                    qoi_enc_rgb(enc, cur_pixel);
-                }
-            }
+    if (!qoi_enc_init(desc, enc, data) || pixel_offset > enc->len) return false;
 
-        }
+    for (uint8_t element = 0; element < 64; element++)
+    {
+        for (uint8_t channel = 0; channel < 4; channel++)
+            enc->buffer[element].channels[channel] = bytes[40 + element * 4 + channel];
     }
 
-    /* Advance the pixel offset by one and sets the previous pixel to the current pixel */
-    enc->prev_pixel = cur_pixel;
-    enc->pixel_offset++;
+    qoi_set_pixel_rgba(&enc->prev_pixel, bytes[20], bytes[21], bytes[22], bytes[23]);
 
-    /* Write QOI padding when finished encoding the image */
-    if (qoi_enc_done(enc))
-    {
-        enc->offset[0] = QOI_PADDING[0];
-        enc->offset[1] = QOI_PADDING[1];
-        enc->offset[2] = QOI_PADDING[2];
-        enc->offset[3] = QOI_PADDING[3];
-        enc->offset[4] = QOI_PADDING[4];
-        enc->offset[5] = QOI_PADDING[5];
-        enc->offset[6] = QOI_PADDING[6];
-        enc->offset[7] = QOI_PADDING[7];
+    enc->run = bytes[18];
+    enc->pixel_offset = (size_t)pixel_offset;
+    enc->offset = enc->data + byte_offset;
 
-        enc->offset += 8;
-    }
+    return true;
 }
 
-/* Get and set the RGB values from the QOI file */
-static inline void qoi_dec_rgb(qoi_dec_t* dec)
+/*
+    Grows the height of an image while it is encoded, for images that get more
+    rows than declared up front. data holds the QOI file written so far, either
+    the same buffer or a larger copy of it, with room for the worst case of the
+    new height. An image that was already complete has its padding taken off
+    again, so encoding carries on after its last pixel. Rewrites the header.
+    Returns false if height is smaller than the current one or too large.
+*/
+bool qoi_enc_extend(qoi_desc_t* desc, qoi_enc_t* enc, uint32_t height, void* data)
 {
-    dec->prev_pixel.red = dec->offset[1];
-    dec->prev_pixel.green = dec->offset[2];
-    dec->prev_pixel.blue = dec->offset[3];
+    size_t used, len;
 
-    dec->offset += 4;
-}
+    if (desc == NULL || enc == NULL || data == NULL || desc->width == 0 || height < desc->height) return false;
+    if ((uint64_t)desc->width * height > ((size_t)-1 - 14 - 8) / ((size_t)desc->channels + 1)) return false;
 
-/* Get and set the RGB values from the QOI file */
-static inline void qoi_dec_rgba(qoi_dec_t* dec)
-{
-    dec->prev_pixel.red = dec->offset[1];
-    dec->prev_pixel.green = dec->offset[2];
-    dec->prev_pixel.blue = dec->offset[3];
-    dec->prev_pixel.alpha = dec->offset[4];
+    used = (size_t)(enc->offset - enc->data);
+    len = (size_t)desc->width * height;
 
-    dec->offset += 5;
-}
+    /* The last pixel wrote the padding; the next chunk goes where it was */
+    if (qoi_enc_done(enc) && enc->pixel_offset > 0 && len > enc->pixel_offset)
+        used -= 8;
 
-/* Get and set the seek position of the buffer from the QOI file */
-static inline void qoi_dec_index(qoi_dec_t* dec, uint8_t tag)
-{
-    dec->prev_pixel = dec->buffer[tag & QOI_TAG_MASK];
+    desc->height = height;
 
-    dec->offset += 1;
+    enc->data = (uint8_t*)data;
+    enc->offset = enc->data + used;
+    enc->len = len;
+
+    write_qoi_header(desc, enc->data);
+
+    return true;
 }
 
-/* Get the differences between values of the color channels from the QOI file */
-static inline void qoi_dec_diff(qoi_dec_t* dec, uint8_t tag)
+/*
+    Ends an image after the rows encoded so far, for images whose final height
+    is not known up front: start with a height large enough for any of them,
+    or grow it with qoi_enc_extend as rows arrive. Flushes a pending run,
+    writes QOI_PADDING and rewrites the header with the height actually
+    encoded. Returns false if a row is only partly encoded.
+*/
+bool qoi_enc_finish(qoi_desc_t* desc, qoi_enc_t* enc)
 {
-    uint8_t diff = tag & QOI_TAG_MASK;
+    if (desc == NULL || enc == NULL || desc->width == 0) return false;
 
-    /* Do some wizardary to get the differences between three color channel values */
+    /* The last pixel already wrote the padding */
+    if (qoi_enc_done(enc)) return true;
 
-    uint8_t red_diff = ((diff >> 4) & 0x03) - 2;
-    uint8_t green_diff = ((diff >> 2) & 0x03) - 2;
-    uint8_t blue_diff = (diff & 0x03) - 2;
+    if (enc->pixel_offset == 0 || enc->pixel_offset % desc->width != 0) return false;
 
-    /* Add up the differences between three color channel values individually */
+    if (enc->run > 0)
+        qoi_enc_run(enc);
 
-    dec->prev_pixel.red += red_diff;
-    dec->prev_pixel.green += green_diff;
-    dec->prev_pixel.blue += blue_diff;
+    desc->height = (uint32_t)(enc->pixel_offset / desc->width);
+    enc->len = enc->pixel_offset;
 
-    dec->offset += 1;
+    qoi_enc_padding(enc);
+    write_qoi_header(desc, enc->data);
+
+    return true;
 }
 
-/* Gets the luma values from the QOI file */
-static inline void qoi_dec_luma(qoi_dec_t* dec, uint8_t tag)
+#ifdef QOI_RING_AVAILABLE
+/* Size of the rows of a decode-ahead ring. Returns 0 for unsupported or too large images. */
+size_t qoi_ring_buffer_size(qoi_desc_t* desc, uint32_t slots, uint32_t rows_per_slot)
 {
-    uint8_t lumaGreen = (tag & QOI_TAG_MASK) - 32;
+    size_t row_size;
 
-    /* Do some lumaGreen wizardary to get and add the differences between three color channel values */
+    if (desc == NULL || desc->channels < 3 || desc->channels > 4 || slots == 0 || rows_per_slot == 0) return 0;
 
-    dec->prev_pixel.red += lumaGreen + ((dec->offset[1] & 0xF0) >> 4) - 8;
-    dec->prev_pixel.green += lumaGreen;
-    dec->prev_pixel.blue += lumaGreen + (dec->offset[1] & 0x0F) - 8;
+    row_size = (size_t)desc->width * desc->channels;
 
-    dec->offset += 2;
+    if (desc->width > SIZE_MAX / desc->channels || (row_size > 0 && (size_t)rows_per_slot * slots > SIZE_MAX / row_size)) return 0;
+
+    return row_size * rows_per_slot * slots;
 }
 
-/* Gets the run length of the pixel from the QOI file */
-static inline void qoi_dec_run(qoi_dec_t* dec, uint8_t tag){
-    dec->run = tag & QOI_TAG_MASK;
+/*
+    Prepares a ring over an initialized decoder. buffer must hold
+    qoi_ring_buffer_size(desc, slots, rows_per_slot) bytes; more slots let
+    the producer get further ahead of a consumer that is slow now and then.
+*/
+bool qoi_ring_init(qoi_ring_t* ring, qoi_desc_t* desc, qoi_dec_t* dec, void* buffer, uint32_t slots, uint32_t rows_per_slot, void (*wait_fn)(void* user), void* user)
+{
+    if (ring == NULL || dec == NULL || buffer == NULL || qoi_ring_buffer_size(desc, slots, rows_per_slot) == 0) return false;
+
+    ring->desc = desc;
+    ring->dec = dec;
+    ring->rows = (uint8_t*)buffer;
+    ring->slot_size = (size_t)desc->width * desc->channels * rows_per_slot;
+    ring->slots = slots;
+    ring->rows_per_slot = rows_per_slot;
+    ring->batches = ((size_t)desc->height + rows_per_slot - 1) / rows_per_slot;
+    ring->wait_fn = wait_fn;
+    ring->user = user;
+
+    atomic_init(&ring->failed, false);
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
 
-    dec->offset += 1;
+    return true;
 }
 
-/* 
-    WARNING: In this function below, you must provide enough memory to put the decoded images 
-    The safest amount of space to store decoded images is the equation below
+/* Gets the number of rows in a batch; the last one may be short */
+static inline uint32_t qoi_ring_batch_rows(const qoi_ring_t* ring, size_t batch)
+{
+    size_t first_row = batch * ring->rows_per_slot;
 
-    (image width) * (image height) * (amount of channels in a pixel) = bytes required to store decoded image
-*/
+    return (ring->desc->height - first_row < ring->rows_per_slot) ? (uint32_t)(ring->desc->height - first_row) : ring->rows_per_slot;
+}
 
-qoi_pixel_t qoi_decode_chunk(qoi_dec_t* dec)
+/*
+    Decodes the whole image into the ring, waiting whenever every slot is
+    still held by the consumer. Run it on the producer thread; it returns
+    once the last batch is published or the stream ended early.
+*/
+void qoi_ring_produce(qoi_ring_t* ring)
 {
+    uint8_t channels = ring->desc->channels;
 
-    if (dec->run > 0)
-        dec->run--;
-
-    else
+    for (size_t batch = 0; batch < ring->batches; batch++)
     {
-        uint8_t tag = dec->offset[0]; /* opcode for qoi decompression */
-
-        /*  
-            The 8-bit tags have precedence over the 2-bit tags. 
-            A decoder must check for the presence of an 8-bit tag first. 
-        */
+        uint8_t* bytes = ring->rows + (batch % ring->slots) * ring->slot_size;
+        size_t pixels = (size_t)qoi_ring_batch_rows(ring, batch) * ring->desc->width;
 
-        if (tag == QOI_OP_RGB) /* RGB pixel */
-        {
-            qoi_dec_rgb(dec);
-        }
-        else if (tag == QOI_OP_RGBA) /* RGBA pixel */
+        /* Backpressure: the slot is free once the consumer released the batch before it */
+        while (batch - atomic_load_explicit(&ring->tail, memory_order_acquire) >= ring->slots)
         {
-            qoi_dec_rgba(dec);
+            if (ring->wait_fn) ring->wait_fn(ring->user);
         }
-        else
+
+        for (size_t pixel = 0; pixel < pixels; pixel++)
         {
-            uint8_t tag_type = (tag & QOI_TAG); /* opcode for qoi decompression */
+            qoi_pixel_t px;
 
-            switch(tag_type)
+            if (qoi_dec_done(ring->dec))
             {
-                case QOI_OP_INDEX:
-                {
-                    qoi_dec_index(dec, tag);
-
-                    break;
-                }
-                case QOI_OP_DIFF:
-                {
-                    qoi_dec_diff(dec, tag);
+                atomic_store_explicit(&ring->failed, true, memory_order_release);
+                return;
+            }
 
-                    break;
-                }
-                case QOI_OP_LUMA:
-                {
-                    qoi_dec_luma(dec, tag);
+            px = qoi_decode_chunk(ring->dec);
 
-                    break;
-                }
-                case QOI_OP_RUN:
-                {
-                    qoi_dec_run(dec, tag);
+            bytes[0] = px.red;
+            bytes[1] = px.green;
+            bytes[2] = px.blue;
 
-                    break;
-                }
-                default:
-                {
-                    dec->offset += 1; /* move on to the new packet if there is an invaild opcode */
+            if (channels > 3) bytes[3] = px.alpha;
 
-                    break;
-                }
-            }           
+            bytes += channels;
         }
 
-        dec->buffer[qoi_get_index_position(dec->prev_pixel)] = dec->prev_pixel;           
+        /* The rows must be visible before the batch is */
+        atomic_store_explicit(&ring->head, batch + 1, memory_order_release);
     }
-    
-    dec->pixel_seek++;
-    return dec->prev_pixel;
 }
 
+/*
+    Waits for the next batch of rows and returns it, with the row it starts at
+    and how many rows it holds. The rows stay valid until qoi_ring_release.
+    Returns NULL after the last batch or if the stream ended early.
+*/
+const uint8_t* qoi_ring_acquire(qoi_ring_t* ring, uint32_t* first_row, uint32_t* row_count)
+{
+    size_t batch = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    if (batch >= ring->batches) return NULL;
+
+    while (atomic_load_explicit(&ring->head, memory_order_acquire) <= batch)
+    {
+        if (atomic_load_explicit(&ring->failed, memory_order_acquire)) return NULL;
+        if (ring->wait_fn) ring->wait_fn(ring->user);
+    }
+
+    if (first_row) *first_row = (uint32_t)(batch * ring->rows_per_slot);
+    if (row_count) *row_count = qoi_ring_batch_rows(ring, batch);
+
+    return ring->rows + (batch % ring->slots) * ring->slot_size;
+}
+
+/* Hands the batch from qoi_ring_acquire back to the producer */
+void qoi_ring_release(qoi_ring_t* ring)
+{
+    size_t batch = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    atomic_store_explicit(&ring->tail, batch + 1, memory_order_release);
+}
+
+/* Did the stream end before every row was decoded? */
+bool qoi_ring_failed(qoi_ring_t* ring)
+{
+    return atomic_load_explicit(&ring->failed, memory_order_acquire);
+}
+#endif
+
 #ifdef __cplusplus
 }
 #endif
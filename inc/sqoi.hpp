@@ -0,0 +1,414 @@
+/*
+
+    THE QUITE OK IMAGE FORMAT - C++17 interface
+
+    Typed encoder and decoder on top of sQOI.h. The channel count and channel
+    order are template parameters and the pixels are coded by the encoder and
+    decoder of sQOI.h, so both headers produce the same QOI files.
+
+    This header includes sQOI.h with its implementation, so like sQOI.h it goes
+    in only "one" of your source files, after SIMPLIFIED_QOI_IMPLEMENTATION
+    is defined.
+
+    #define SIMPLIFIED_QOI_IMPLEMENTATION
+    #include "sqoi.hpp"
+
+    std::vector<uint8_t> pixels = ...; // RGBA
+    sqoi::buffer qoi_file = sqoi::encoder<4>::encode(pixels, width, height);
+
+    sqoi::desc info;
+    sqoi::buffer rgb = sqoi::decoder<3>::decode(qoi_file, &info);
+
+    Requires C++17; uses std::span when compiled as C++20 or newer.
+
+*/
+
+/*
+
+    MIT License
+
+    Copyright (c) 2024-2026 Aftersol
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+
+*/
+
+#ifndef SIMPLIFIED_QOI_HPP
+#define SIMPLIFIED_QOI_HPP
+
+#ifndef SIMPLIFIED_QOI_IMPLEMENTATION
+#error "Define SIMPLIFIED_QOI_IMPLEMENTATION before including sqoi.hpp in one source file"
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <type_traits>
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+#include <span>
+#endif
+
+#include "sQOI.h"
+
+namespace sqoi
+{
+
+#if defined(__cpp_lib_span)
+template <class T>
+using span = std::span<T>;
+#else
+/* Minimal stand in for std::span before C++20 */
+template <class T>
+class span
+{
+public:
+    constexpr span() noexcept : ptr(nullptr), count(0) {}
+    constexpr span(T* data, std::size_t size) noexcept : ptr(data), count(size) {}
+
+    template <std::size_t N>
+    constexpr span(T (&array)[N]) noexcept : ptr(array), count(N) {}
+
+    /* Any contiguous container such as std::vector, std::array or std::string */
+    template <
+        class Container,
+        class = std::enable_if_t<
+            !std::is_same_v<std::remove_cv_t<std::remove_reference_t<Container>>, span> &&
+            std::is_convertible_v<decltype(std::declval<Container&>().data()), T*>
+        >
+    >
+    constexpr span(Container& container) noexcept : ptr(container.data()), count(container.size()) {}
+
+    /* span<const T> from span<T> */
+    template <class U, class = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    constexpr span(const span<U>& other) noexcept : ptr(other.data()), count(other.size()) {}
+
+    constexpr T* data() const noexcept { return ptr; }
+    constexpr std::size_t size() const noexcept { return count; }
+    constexpr bool empty() const noexcept { return count == 0; }
+    constexpr T& operator[](std::size_t index) const noexcept { return ptr[index]; }
+    constexpr T* begin() const noexcept { return ptr; }
+    constexpr T* end() const noexcept { return ptr + count; }
+
+private:
+    T* ptr;
+    std::size_t count;
+};
+#endif
+
+enum class colorspace : uint8_t { srgb = 0, linear = 1 };
+
+/* Order of the color channels in interleaved pixels; alpha always comes last */
+enum class layout { rgba, bgra };
+
+/* QOI descriptor as read by the header */
+struct desc
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint8_t channels = 0;
+    sqoi::colorspace colorspace = sqoi::colorspace::srgb;
+};
+
+/* Move only buffer owning exactly size() bytes */
+class buffer
+{
+public:
+    buffer() noexcept = default;
+
+    buffer(buffer&&) noexcept = default;
+    buffer& operator=(buffer&&) noexcept = default;
+
+    buffer(const buffer&) = delete;
+    buffer& operator=(const buffer&) = delete;
+
+    uint8_t* data() noexcept { return bytes.get(); }
+    const uint8_t* data() const noexcept { return bytes.get(); }
+    std::size_t size() const noexcept { return length; }
+    bool empty() const noexcept { return length == 0; }
+    explicit operator bool() const noexcept { return length != 0; }
+
+    uint8_t* begin() noexcept { return data(); }
+    uint8_t* end() noexcept { return data() + length; }
+    const uint8_t* begin() const noexcept { return data(); }
+    const uint8_t* end() const noexcept { return data() + length; }
+
+    /* Allocates an uninitialized buffer; empty if the allocation fails */
+    static buffer allocate(std::size_t size) noexcept
+    {
+        buffer result;
+
+        result.bytes.reset(static_cast<uint8_t*>(std::malloc(size ? size : 1)));
+        result.length = result.bytes ? size : 0;
+
+        return result;
+    }
+
+    /* Shrinks the buffer to its first size bytes, normally without copying */
+    void shrink(std::size_t size) noexcept
+    {
+        if (size >= length) return;
+
+        if (void* smaller = std::realloc(bytes.get(), size ? size : 1))
+        {
+            bytes.release();
+            bytes.reset(static_cast<uint8_t*>(smaller));
+        }
+
+        length = size;
+    }
+
+private:
+    struct free_deleter
+    {
+        void operator()(uint8_t* ptr) const noexcept { std::free(ptr); }
+    };
+
+    std::unique_ptr<uint8_t[], free_deleter> bytes;
+    std::size_t length = 0;
+};
+
+namespace detail
+{
+    /* Channel positions of a layout inside interleaved pixels */
+    template <layout Layout>
+    struct order;
+
+    template <>
+    struct order<layout::rgba>
+    {
+        static constexpr std::size_t red = 0, green = 1, blue = 2;
+    };
+
+    template <>
+    struct order<layout::bgra>
+    {
+        static constexpr std::size_t red = 2, green = 1, blue = 0;
+    };
+
+    inline qoi_desc_t to_qoi(const desc& info) noexcept
+    {
+        qoi_desc_t qoi;
+
+        qoi_desc_init(&qoi);
+        qoi_set_dimensions(&qoi, info.width, info.height);
+        qoi_set_channels(&qoi, info.channels);
+        qoi_set_colorspace(&qoi, static_cast<uint8_t>(info.colorspace));
+
+        return qoi;
+    }
+}
+
+/* Size of the QOI header and of the end marker */
+inline constexpr std::size_t header_size = 14;
+inline constexpr std::size_t padding_size = sizeof(QOI_PADDING);
+
+/* Reads the QOI header; returns false if data is not a QOI file */
+inline bool read_header(span<const uint8_t> data, desc& info) noexcept
+{
+    qoi_desc_t qoi;
+
+    if (data.size() < header_size) return false;
+
+    qoi_desc_init(&qoi);
+
+    if (!read_qoi_header(&qoi, const_cast<uint8_t*>(data.data()))) return false;
+
+    info.width = qoi.width;
+    info.height = qoi.height;
+    info.channels = qoi.channels;
+    info.colorspace = static_cast<sqoi::colorspace>(qoi.colorspace);
+
+    return true;
+}
+
+/* Writes the 14 byte QOI header */
+inline void write_header(const desc& info, uint8_t* dest) noexcept
+{
+    qoi_desc_t qoi = detail::to_qoi(info);
+
+    write_qoi_header(&qoi, dest);
+}
+
+/* Encodes interleaved pixels with Channels channels (3 or 4) ordered by Layout */
+template <unsigned Channels, layout Layout = layout::rgba>
+class encoder
+{
+    static_assert(Channels == 3 || Channels == 4, "QOI images have 3 or 4 channels");
+
+    using order = detail::order<Layout>;
+
+public:
+    /* Bytes needed to encode any image of this size or 0 if that does not fit in size_t */
+    static constexpr std::size_t max_size(uint32_t width, uint32_t height) noexcept
+    {
+        if (height != 0 && width > (SIZE_MAX - header_size - padding_size) / height / (Channels + 1))
+            return 0;
+
+        return std::size_t(width) * std::size_t(height) * (Channels + 1) + header_size + padding_size;
+    }
+
+    /*
+        Encodes into out, which must hold max_size(width, height) bytes.
+        Returns the length of the QOI file or 0 on failure.
+    */
+    static std::size_t encode(span<const uint8_t> pixels, uint32_t width, uint32_t height, span<uint8_t> out, sqoi::colorspace space = sqoi::colorspace::srgb) noexcept
+    {
+        const std::size_t size = max_size(width, height);
+
+        if (width == 0 || height == 0 || size == 0 || out.size() < size)
+            return 0;
+
+        if (pixels.size() / Channels < std::size_t(width) * std::size_t(height))
+            return 0;
+
+        qoi_desc_t qoi = detail::to_qoi(desc{width, height, uint8_t(Channels), space});
+        qoi_enc_t enc;
+        const uint8_t* seek = pixels.data();
+
+        write_qoi_header(&qoi, out.data());
+
+        if (!qoi_enc_init(&qoi, &enc, out.data()))
+            return 0;
+
+        while (!qoi_enc_done(&enc))
+        {
+            qoi_pixel_t px;
+
+            if constexpr (Channels == 4)
+                qoi_set_pixel_rgba(&px, seek[order::red], seek[order::green], seek[order::blue], seek[3]);
+            else
+                qoi_set_pixel_rgba(&px, seek[order::red], seek[order::green], seek[order::blue], 255);
+
+            qoi_encode_pixel(&qoi, &enc, px);
+            seek += Channels;
+        }
+
+        return static_cast<std::size_t>(enc.offset - enc.data);
+    }
+
+    /* Encodes into a buffer holding exactly the QOI file; empty on failure */
+    static buffer encode(span<const uint8_t> pixels, uint32_t width, uint32_t height, sqoi::colorspace space = sqoi::colorspace::srgb) noexcept
+    {
+        const std::size_t size = max_size(width, height);
+
+        if (size == 0) return buffer();
+
+        buffer qoi_file = buffer::allocate(size);
+
+        if (qoi_file.empty()) return qoi_file;
+
+        const std::size_t len = encode(pixels, width, height, span<uint8_t>(qoi_file.data(), qoi_file.size()), space);
+
+        if (len == 0) return buffer();
+
+        qoi_file.shrink(len);
+
+        return qoi_file;
+    }
+};
+
+/*
+    Decodes QOI files into interleaved pixels with Channels channels (3 or 4) ordered by Layout
+    regardless of the amount of channels stored in the file.
+*/
+template <unsigned Channels, layout Layout = layout::rgba>
+class decoder
+{
+    static_assert(Channels == 3 || Channels == 4, "QOI images have 3 or 4 channels");
+
+    using order = detail::order<Layout>;
+
+public:
+    /* Bytes needed to hold the decoded image or 0 if that does not fit in size_t */
+    static constexpr std::size_t raw_size(const desc& info) noexcept
+    {
+        if (info.height != 0 && info.width > SIZE_MAX / info.height / Channels)
+            return 0;
+
+        return std::size_t(info.width) * std::size_t(info.height) * Channels;
+    }
+
+    /*
+        Decodes into out, which must hold raw_size() bytes.
+        Returns false if data is not a valid QOI file, the stream ends before
+        every pixel is decoded or out is too small. info is only set on success.
+    */
+    static bool decode(span<const uint8_t> data, span<uint8_t> out, desc* info = nullptr) noexcept
+    {
+        desc header;
+
+        if (!read_header(data, header) || data.size() < header_size + padding_size) return false;
+        if (header.channels < 3 || header.channels > 4 || header.width == 0 || header.height == 0) return false;
+
+        const std::size_t size = raw_size(header);
+
+        if (size == 0 || out.size() < size) return false;
+
+        qoi_desc_t qoi = detail::to_qoi(header);
+        qoi_dec_t dec;
+        uint8_t* write = out.data();
+
+        if (!qoi_dec_init(&qoi, &dec, const_cast<uint8_t*>(data.data()), data.size())) return false;
+
+        while (!qoi_dec_done(&dec))
+        {
+            const qoi_pixel_t px = qoi_decode_chunk(&dec);
+
+            write[order::red] = px.red;
+            write[order::green] = px.green;
+            write[order::blue] = px.blue;
+
+            if constexpr (Channels == 4)
+                write[3] = px.alpha;
+
+            write += Channels;
+        }
+
+        if (dec.pixel_seek < dec.img_area) return false;
+
+        if (info) *info = header;
+
+        return true;
+    }
+
+    /* Decodes into a buffer holding exactly the raw image; empty on failure */
+    static buffer decode(span<const uint8_t> data, desc* info = nullptr) noexcept
+    {
+        desc header;
+
+        if (!read_header(data, header) || header.channels < 3 || header.channels > 4) return buffer();
+
+        const std::size_t size = raw_size(header);
+
+        if (size == 0) return buffer();
+
+        buffer pixels = buffer::allocate(size);
+
+        if (pixels.empty() || !decode(data, span<uint8_t>(pixels.data(), pixels.size()), info))
+            return buffer();
+
+        return pixels;
+    }
+};
+
+} /* namespace sqoi */
+
+#endif /* SIMPLIFIED_QOI_HPP */
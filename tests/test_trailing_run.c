@@ -0,0 +1,115 @@
+/*
+
+    -- test_trailing_run.c -- Regression test for runs that end on the last pixel
+
+    The encoder used to check for the end of the image before counting the
+    current pixel, so a run reaching the last pixel was never written and the
+    decoder read the padding as pixels. Every image here ends in a run of a
+    different length and has to decode back to the same pixels.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SIMPLIFIED_QOI_IMPLEMENTATION
+#include "sQOI.h"
+
+static void* stdlib_malloc(size_t size, void* user)
+{
+    (void)user;
+    return malloc(size);
+}
+
+static void stdlib_free(void* ptr, void* user)
+{
+    (void)user;
+    free(ptr);
+}
+
+static const qoi_allocator_t stdlib_allocator = {stdlib_malloc, NULL, stdlib_free, NULL};
+
+/* Encodes a width x 1 image whose last run pixels repeat the pixel before them and checks the round trip */
+static int check_round_trip(uint32_t width, uint32_t run, uint8_t channels)
+{
+    qoi_desc_t desc, decoded_desc;
+    uint8_t* pixels;
+    uint8_t* qoi_file;
+    uint8_t* decoded;
+    size_t len, i;
+    int failed = 0;
+
+    pixels = (uint8_t*)malloc((size_t)width * channels);
+
+    if (pixels == NULL) return 1;
+
+    /* A gradient never repeats a pixel, so the only run is the trailing one */
+    for (i = 0; i < width; i++)
+    {
+        size_t source = (i < width - run) ? i : width - run - 1;
+
+        pixels[i * channels + 0] = (uint8_t)(source * 7 + 10);
+        pixels[i * channels + 1] = (uint8_t)(source * 3 + 20);
+        pixels[i * channels + 2] = (uint8_t)(source * 5 + 30);
+
+        if (channels == 4)
+            pixels[i * channels + 3] = (uint8_t)(200 + source % 2);
+    }
+
+    qoi_desc_init(&desc);
+    qoi_set_dimensions(&desc, width, 1);
+    qoi_set_channels(&desc, channels);
+    qoi_set_colorspace(&desc, QOI_SRGB);
+
+    qoi_file = (uint8_t*)qoi_encode_image(&desc, pixels, &len, &stdlib_allocator);
+
+    if (qoi_file == NULL)
+    {
+        printf("%u x 1 with %u channels: encoding failed\n", width, channels);
+        free(pixels);
+        return 1;
+    }
+
+    /* The chunk right before the padding has to be the trailing run */
+    if (len < 14 + 1 + 8 || (qoi_file[len - 9] & QOI_TAG) != QOI_OP_RUN || memcmp(qoi_file + len - 8, QOI_PADDING, 8) != 0)
+    {
+        printf("%u x 1 with %u channels: the trailing run was not written\n", width, channels);
+        failed = 1;
+    }
+
+    decoded = (uint8_t*)qoi_decode_image(&decoded_desc, qoi_file, len, &stdlib_allocator);
+
+    if (decoded == NULL || memcmp(decoded, pixels, (size_t)width * channels) != 0)
+    {
+        printf("%u x 1 with %u channels: decoded pixels differ\n", width, channels);
+        failed = 1;
+    }
+
+    free(decoded);
+    free(qoi_file);
+    free(pixels);
+
+    return failed;
+}
+
+int main(void)
+{
+    /* Runs of one pixel, a full run chunk, one past it and a whole image of one color */
+    static const uint32_t runs[][2] = {
+        {16, 1}, {16, 2}, {100, 62}, {100, 63}, {200, 124}, {64, 63}
+    };
+    size_t i;
+    int failed = 0;
+
+    for (i = 0; i < sizeof(runs) / sizeof(runs[0]); i++)
+    {
+        failed |= check_round_trip(runs[i][0], runs[i][1], 3);
+        failed |= check_round_trip(runs[i][0], runs[i][1], 4);
+    }
+
+    if (!failed)
+        printf("Every trailing run survived the round trip\n");
+
+    return failed;
+}